@@ -0,0 +1,391 @@
+#ifndef ENIGMA_AUTOTUNE_HPP
+#define ENIGMA_AUTOTUNE_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <optional>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <array>
+#include <mutex>
+
+#include "composite.hpp"
+#include "enigma.hpp"
+#include "table.hpp"
+#include "jit.hpp"
+
+namespace enigma {
+
+  // Backend enum --------------------------------------------------------------
+  // Ways of running an `EnigmaMachine`, all producing identical output:
+  //
+  //  - `plain` - `EnigmaMachine::encodeNext`.
+  //  - `composite` - `CompositeMachine`, rebuilding immediately.
+  //  - `amortised` - `CompositeMachine`, rebuilding ahead of each carry.
+  //  - `table` - `TableMachine`, for small shapes.
+  //  - `jit` - `JitKernel`, where it compiles.
+  //
+  enum class Backend {
+    plain,
+    composite,
+    amortised,
+    table,
+    jit
+  };
+
+  inline constexpr std::size_t backend_count = 5u;
+
+  [[nodiscard]] inline std::string_view getBackendName(Backend backend) {
+    switch (backend) {
+      case Backend::plain: return "plain";
+      case Backend::composite: return "composite";
+      case Backend::amortised: return "amortised";
+      case Backend::table: return "table";
+      case Backend::jit: return "jit";
+    }
+    return "unknown";
+  }
+
+  [[nodiscard]] inline std::optional<Backend>
+  parseBackend(std::string_view name) {
+    for (auto i = 0u; i < backend_count; ++i) {
+      auto backend = static_cast<Backend>(i);
+      if (getBackendName(backend) == name) {
+        return backend;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Autotuner class -----------------------------------------------------------
+  // Process wide cache of backend decisions, keyed by machine shape (code
+  // point size, base, rotor count) and message length class. Decisions are
+  // made by `TunedMachine` on first use of a shape.
+  //
+  // If a cache file is set, decisions are loaded from it and every new
+  // decision is written back. A file recorded on a different CPU (by model
+  // name) is ignored, then overwritten.
+  //
+  class Autotuner {
+  public:
+
+    static Autotuner & getInstance() {
+      static auto instance = Autotuner{};
+      return instance;
+    }
+
+    // getLengthClass --
+    // Message lengths are grouped by powers of 16, from 16 up to 16^6.
+    //
+    [[nodiscard]] static std::size_t getLengthClass(std::size_t length) {
+      auto length_class = std::size_t{1u};
+      while (length_class < 6u && (std::size_t{1u} << 4u * length_class) <
+                                  length) {
+        ++length_class;
+      }
+      return length_class;
+    }
+
+    [[nodiscard]] static std::string
+    makeKey(std::size_t index_size, std::size_t base, std::size_t rotor_count,
+            std::size_t length) {
+      auto key = std::ostringstream{};
+      key << "i" << index_size << "-b" << base << "-r" << rotor_count
+          << "-l" << getLengthClass(length);
+      return key.str();
+    }
+
+    // getCpuName --
+    // The CPU model name, or "unknown" where it cannot be read.
+    //
+    [[nodiscard]] static std::string getCpuName() {
+      auto file = std::ifstream{"/proc/cpuinfo"};
+      for (auto line = std::string{}; std::getline(file, line);) {
+        if (line.compare(0u, 10u, "model name") == 0) {
+          auto colon = line.find(':');
+          auto first = line.find_first_not_of(' ', colon + 1u);
+          if (colon != std::string::npos && first != std::string::npos) {
+            return line.substr(first);
+          }
+        }
+      }
+      return "unknown";
+    }
+
+    // setCachePath --
+    // Loads decisions from `path`, if it exists, and saves new ones to it.
+    //
+    void setCachePath(std::string const & path) {
+      auto lock = std::lock_guard{mutex};
+      cache_path = path;
+
+      auto file = std::ifstream{path};
+      auto line = std::string{};
+      if (!std::getline(file, line) || line != "cpu " + getCpuName()) {
+        return;
+      }
+      for (auto key = std::string{}, name = std::string{};
+           file >> key >> name;) {
+        if (auto backend = parseBackend(name)) {
+          decisions[key] = *backend;
+        }
+      }
+    }
+
+    [[nodiscard]] std::optional<Backend> find(std::string const & key) const {
+      auto lock = std::lock_guard{mutex};
+      auto found = decisions.find(key);
+      if (found == decisions.end()) {
+        return std::nullopt;
+      }
+      return found->second;
+    }
+
+    void store(std::string const & key, Backend backend) {
+      auto lock = std::lock_guard{mutex};
+      decisions[key] = backend;
+      if (cache_path.empty()) {
+        return;
+      }
+
+      auto file = std::ofstream{cache_path};
+      file << "cpu " << getCpuName() << "\n";
+      for (auto const & [other_key, other] : decisions) {
+        file << other_key << " " << getBackendName(other) << "\n";
+      }
+    }
+
+    void clear() {
+      auto lock = std::lock_guard{mutex};
+      decisions.clear();
+    }
+
+  private:
+
+    Autotuner() = default;
+
+    mutable std::mutex mutex;
+    std::string cache_path;
+    std::unordered_map<std::string, Backend> decisions;
+  };
+
+  // TunedMachine class --------------------------------------------------------
+  // Runs an `EnigmaMachine` on whichever backend is fastest for its shape and
+  // the expected message length. On the first use of a shape, each candidate
+  // is built from a copy of the machine and timed on a sample of the message
+  // length (capped at `max_sample`); the cost of a message is estimated as
+  // setup time plus the sampled rate over the full length. Candidates whose
+  // output differs from `plain` are rejected.
+  //
+  // The result is cached in an `Autotuner`, so later machines of the same
+  // shape skip straight to their backend.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class TunedMachine {
+  public:
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using Index = IndexT;
+
+    static constexpr std::size_t max_sample = std::size_t{1u} << 16u;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    TunedMachine() = delete;
+
+    // Constructor --
+    // `machine` - Copied, then run on the chosen backend.
+    // `length` - Expected number of symbols per batch encode.
+    // `tuner` - Cache of decisions.
+    //
+    explicit TunedMachine(MachineType const & machine,
+                          std::size_t length = max_sample,
+                          Autotuner & tuner = Autotuner::getInstance()):
+        machine(machine) {
+      auto key = Autotuner::makeKey(sizeof(Index), base, rotor_count, length);
+      // A cached decision may name a backend this shape cannot use, if the
+      // cache file was edited or written by another build; it is retuned.
+      if (auto found = tuner.find(key); found && isCandidate(*found)) {
+        backend = *found;
+      } else {
+        backend = tune(machine, length);
+        tuner.store(key, backend);
+      }
+      install();
+    }
+
+    // Constructor --
+    // Runs `machine` on `backend`, without tuning, or on `plain` if `backend`
+    // is not available for this shape.
+    //
+    TunedMachine(MachineType const & machine, Backend backend):
+        machine(machine),
+        backend(backend) {
+      install();
+    }
+
+    [[nodiscard]] Backend getBackend() const {
+      return backend;
+    }
+
+    void advance(std::size_t steps = 1u) {
+      switch (backend) {
+        case Backend::composite:
+        case Backend::amortised:
+          composite->advance(steps);
+          break;
+        case Backend::table:
+          table->advance(steps);
+          break;
+        default:
+          machine.advance(steps);
+          break;
+      }
+    }
+
+    // encodeNext --
+    // Encodes the `size` values at `data` in place, advancing before each.
+    //
+    void encodeNext(Index * data, std::size_t size) {
+      switch (backend) {
+        case Backend::composite:
+        case Backend::amortised:
+          composite->encodeNext(data, data + size, data);
+          break;
+        case Backend::table:
+          table->encodeNext(data, data + size, data);
+          break;
+        case Backend::jit:
+          jit->encodeNext(machine, data, size);
+          break;
+        case Backend::plain:
+          for (auto i = std::size_t{0u}; i < size; ++i) {
+            data[i] = machine.encodeNext(data[i]);
+          }
+          break;
+      }
+    }
+
+    Index encodeNext(Index val) {
+      encodeNext(&val, 1u);
+      return val;
+    }
+
+    // tune --
+    // Times every candidate backend on `machine` for messages of `length`
+    // symbols and returns the fastest.
+    //
+    [[nodiscard]] static Backend tune(MachineType const & machine,
+                                      std::size_t length) {
+      using Clock = std::chrono::steady_clock;
+
+      auto sample_size = std::min(std::max(length, std::size_t{1u}),
+                                  max_sample);
+      auto input = std::vector<Index>(sample_size);
+      for (auto i = 0u; i < sample_size; ++i) {
+        input[i] = static_cast<Index>((i * 7u + i / base) % base);
+      }
+
+      auto expected = input;
+      TunedMachine{machine, Backend::plain}.encodeNext(expected.data(),
+                                                        sample_size);
+
+      auto best = Backend::plain;
+      auto best_cost = 0.0;
+      for (auto i = 0u; i < backend_count; ++i) {
+        auto candidate = static_cast<Backend>(i);
+        if (!isCandidate(candidate)) {
+          continue;
+        }
+
+        auto output = input;
+        auto begin = Clock::now();
+        auto tuned = TunedMachine{machine, candidate};
+        auto built = Clock::now();
+        tuned.encodeNext(output.data(), sample_size);
+        auto end = Clock::now();
+
+        if (candidate == Backend::jit && !tuned.jit->isCompiled()) {
+          continue;
+        }
+        if (output != expected) {
+          assert(false && "backend output differs from EnigmaMachine");
+          continue;
+        }
+
+        auto setup = std::chrono::duration<double>(built - begin).count();
+        auto run = std::chrono::duration<double>(end - built).count();
+        auto cost = setup + run * length / sample_size;
+        if (i == 0u || cost < best_cost) {
+          best = candidate;
+          best_cost = cost;
+        }
+      }
+      return best;
+    }
+
+  private:
+
+    static constexpr bool isCandidate(Backend backend) {
+      return backend != Backend::table ||
+        TableMachine<IndexT, base, rotor_count>::isPractical();
+    }
+
+    void install() {
+      switch (backend) {
+        case Backend::composite:
+          composite.emplace(machine, RebuildMode::immediate);
+          break;
+        case Backend::amortised:
+          composite.emplace(machine, RebuildMode::amortised);
+          break;
+        case Backend::table:
+          if constexpr (isCandidate(Backend::table)) {
+            table = std::make_unique<TableMachine<IndexT, base, rotor_count>>(
+              machine);
+          } else {
+            backend = Backend::plain;
+          }
+          break;
+        case Backend::jit:
+          jit = std::make_unique<JitKernel<IndexT, base, rotor_count>>(
+            machine);
+          break;
+        case Backend::plain:
+          break;
+      }
+    }
+
+    MachineType machine;
+    Backend backend;
+    std::optional<CompositeMachine<IndexT, base, rotor_count>> composite;
+    std::unique_ptr<TableMachine<IndexT, base, rotor_count>> table;
+    std::unique_ptr<JitKernel<IndexT, base, rotor_count>> jit;
+  };
+
+  // TunedMachine class deduction guides ---------------------------------------
+
+  template<class T, class ... Args> TunedMachine(T const &, Args && ...) ->
+    TunedMachine<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_AUTOTUNE_HPP
@@ -0,0 +1,374 @@
+#ifndef ENIGMA_BASE64_HPP
+#define ENIGMA_BASE64_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <array>
+
+#include "composite.hpp"
+#include "enigma.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ENIGMA_BASE64_VBMI 1
+#endif
+
+namespace enigma {
+
+  // Base64 alphabet -----------------------------------------------------------
+  // The standard alphabet (RFC 4648), code point `i` being its `i`-th symbol.
+  //
+
+  inline constexpr char base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  namespace detail {
+
+    inline constexpr std::uint8_t base64_invalid = 0x80u;
+
+    // makeBase64Index --
+    // Maps each byte to its code point, or `base64_invalid`.
+    //
+    constexpr std::array<std::uint8_t, 256u> makeBase64Index() {
+      auto index = std::array<std::uint8_t, 256u>{};
+      for (auto & val : index) {
+        val = base64_invalid;
+      }
+      for (auto i = 0u; i < 64u; ++i) {
+        index[static_cast<unsigned char>(base64_alphabet[i])] =
+          static_cast<std::uint8_t>(i);
+      }
+      return index;
+    }
+
+    inline constexpr auto base64_index = makeBase64Index();
+
+  }
+
+  // Base64Codec class ---------------------------------------------------------
+  // Enciphers binary data straight to Base64 text, and back, with a base-64
+  // `EnigmaMachine`. Each group of three bytes is split into four 6-bit code
+  // points, which are enciphered in order and written as the alphabet's
+  // symbols. The output is that of Base64-encoding the data, mapping the
+  // text to code points, enciphering them with `encodeNext` and mapping
+  // them back, but in one pass with no intermediate buffers.
+  //
+  // Enciphering goes through a `CompositeMachine`. On CPUs with AVX-512
+  // VBMI, 48 bytes at a time are split into 64 code points with a byte
+  // permute and a multishift, and the 64 code points are enciphered
+  // together: between carries out of the first rotor the inner composite is
+  // fixed and the first rotor's position is the lane number plus a
+  // constant, so each stage of `CompositeMachine::encode` is one permute
+  // over the 64-entry table, offsets wrapping for free in the permute's six
+  // index bits. Lanes are enciphered a run between carries at a time,
+  // typically two runs per block. Decoding is the reverse, with a permute
+  // over the 128 ASCII codes mapping and validating the text.
+  //
+  // Input to `encode` is padded with `=` when it is not a whole number of
+  // groups, so a stream split across calls must pass multiples of three
+  // bytes until the last. Padding is not enciphered and does not step the
+  // machine. `decode` accepts padding only in the last group of its input
+  // and no line breaks.
+  //
+  template<std::size_t rotor_count>
+  class Base64Codec {
+  public:
+
+    using MachineType = EnigmaMachine<std::uint8_t, 64u, rotor_count>;
+    using PositionArray = typename MachineType::PositionArray;
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    // getEncodedSize --
+    // Characters written by `encode` for `size` bytes.
+    //
+    static constexpr std::size_t getEncodedSize(std::size_t size) {
+      return (size + 2u) / 3u * 4u;
+    }
+
+    // getDecodedSize --
+    // Bytes written by `decode` for `size` characters, at most.
+    //
+    static constexpr std::size_t getDecodedSize(std::size_t size) {
+      return size / 4u * 3u;
+    }
+
+    Base64Codec() = delete;
+
+    explicit Base64Codec(MachineType const & machine):
+        composite(machine) {
+      auto const & first = machine.getRotors()[0];
+      auto const & notches = first.getNotches();
+      for (auto p = 0u; p < base; ++p) {
+        forward[p] = first.getForwardCipher()[p];
+        reverse[p] = first.getReverseCipher()[p];
+        auto distance = 1u;
+        while (distance < base &&
+               (rotor_count == 1u || !notches[(p + distance) % base])) {
+          ++distance;
+        }
+        runs[p] = static_cast<std::uint8_t>(distance);
+      }
+    }
+
+    [[nodiscard]] PositionArray const & getPositions() const {
+      return composite.getPositions();
+    }
+
+    // encode --
+    // Enciphers `size` bytes into `getEncodedSize(size)` characters at
+    // `text`. Returns the number of characters written.
+    //
+    std::size_t encode(std::uint8_t const * bytes, std::size_t size,
+                       char * text) {
+      auto * out = text;
+#if defined(ENIGMA_BASE64_VBMI)
+      if (has_vbmi) {
+        for (; size >= 48u; bytes += 48u, size -= 48u, out += 64u) {
+          encodeBlockVbmi(bytes, out);
+        }
+      }
+#endif
+      for (; size >= 3u; bytes += 3u, size -= 3u, out += 4u) {
+        auto group = std::uint32_t{bytes[0]} << 16u |
+                     std::uint32_t{bytes[1]} << 8u | bytes[2];
+        for (auto i = 0u; i < 4u; ++i) {
+          out[i] = encodeSymbol(group >> (18u - 6u * i));
+        }
+      }
+      if (size > 0u) {
+        auto group = std::uint32_t{bytes[0]} << 16u;
+        if (size > 1u) {
+          group |= std::uint32_t{bytes[1]} << 8u;
+        }
+        for (auto i = 0u; i < 4u; ++i) {
+          out[i] = i <= size ? encodeSymbol(group >> (18u - 6u * i)) : '=';
+        }
+        out += 4u;
+      }
+      return static_cast<std::size_t>(out - text);
+    }
+
+    // decode --
+    // Deciphers `size` characters of text into at most
+    // `getDecodedSize(size)` bytes at `bytes`. Returns the number of bytes
+    // written. Throws `std::invalid_argument` if the text is not Base64;
+    // the machine has then stepped over the groups before the error.
+    //
+    std::size_t decode(char const * text, std::size_t size,
+                       std::uint8_t * bytes) {
+      if (size % 4u != 0u) {
+        throw std::invalid_argument(
+          "Base64 text length is not a multiple of four");
+      }
+
+      auto * out = bytes;
+      auto * first = text;
+#if defined(ENIGMA_BASE64_VBMI)
+      if (has_vbmi) {
+        for (; size >= 64u && decodeBlockVbmi(text, out);
+             text += 64u, size -= 64u, out += 48u) {}
+      }
+#endif
+      for (; size > 0u; text += 4u, size -= 4u) {
+        auto symbols = 4u;
+        if (size == 4u && text[3] == '=') {
+          symbols = text[2] == '=' ? 2u : 3u;
+        }
+
+        auto indices = std::array<std::uint8_t, 4u>{};
+        for (auto i = 0u; i < symbols; ++i) {
+          indices[i] = detail::base64_index[static_cast<unsigned char>(
+            text[i])];
+          if (indices[i] == detail::base64_invalid) {
+            throw std::invalid_argument(
+              "invalid Base64 character at offset " +
+              std::to_string(text + i - first));
+          }
+        }
+
+        auto group = std::uint32_t{0u};
+        for (auto i = 0u; i < symbols; ++i) {
+          group |= std::uint32_t{composite.decodeNext(indices[i])} <<
+                   (18u - 6u * i);
+        }
+        for (auto i = 0u; i + 1u < symbols; ++i) {
+          *out++ = static_cast<std::uint8_t>(group >> (16u - 8u * i));
+        }
+      }
+      return static_cast<std::size_t>(out - bytes);
+    }
+
+  private:
+
+    static constexpr std::size_t base = 64u;
+
+    char encodeSymbol(std::uint32_t index) {
+      return base64_alphabet[composite.encodeNext(index & 0x3Fu)];
+    }
+
+#if defined(ENIGMA_BASE64_VBMI)
+    static inline bool const has_vbmi =
+      __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512vbmi");
+
+    // Permute tables --
+    // `split` gathers the bytes of each group as two big-endian 16-bit
+    // words, `[1, 0, 2, 1]`, for the multishift to cut four code points
+    // from. `pack` gathers the low three bytes of each 32-bit group,
+    // most significant first.
+
+    static constexpr std::array<std::uint8_t, 64u> makeSplit() {
+      auto split = std::array<std::uint8_t, 64u>{};
+      for (auto g = 0u; g < 16u; ++g) {
+        split[4u * g] = static_cast<std::uint8_t>(3u * g + 1u);
+        split[4u * g + 1u] = static_cast<std::uint8_t>(3u * g);
+        split[4u * g + 2u] = static_cast<std::uint8_t>(3u * g + 2u);
+        split[4u * g + 3u] = static_cast<std::uint8_t>(3u * g + 1u);
+      }
+      return split;
+    }
+
+    static constexpr std::array<std::uint8_t, 64u> makePack() {
+      auto pack = std::array<std::uint8_t, 64u>{};
+      for (auto g = 0u; g < 16u; ++g) {
+        for (auto i = 0u; i < 3u; ++i) {
+          pack[3u * g + i] = static_cast<std::uint8_t>(4u * g + 2u - i);
+        }
+      }
+      return pack;
+    }
+
+    static constexpr std::array<std::uint8_t, 64u> makeLanes() {
+      auto lanes = std::array<std::uint8_t, 64u>{};
+      for (auto i = 0u; i < 64u; ++i) {
+        lanes[i] = static_cast<std::uint8_t>(i);
+      }
+      return lanes;
+    }
+
+    static constexpr auto split = makeSplit();
+    static constexpr auto pack = makePack();
+    static constexpr auto lanes = makeLanes();
+    static constexpr auto block_mask = __mmask64{0xFFFFFFFFFFFFu};
+
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) static __m512i
+    load(void const * table) {
+      return _mm512_loadu_si512(table);
+    }
+
+    // permute --
+    // `_mm512_permutexvar_epi8` through the zero-masking form with every
+    // lane selected. GCC's unmasked forms pass an undefined vector as the
+    // merge source, which `-Wall` reports as used uninitialised.
+    //
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) static __m512i
+    permute(__m512i index, __m512i table) {
+      return _mm512_maskz_permutexvar_epi8(~__mmask64{0u}, index, table);
+    }
+
+    // encipherVbmi --
+    // Steps the machine 64 times, enciphering (or deciphering) lane `i` of
+    // `val` at the `i`-th step.
+    //
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) __m512i
+    encipherVbmi(__m512i val, bool decoding) {
+      auto const first_forward = load(forward.data());
+      auto const first_reverse = load(reverse.data());
+      auto result = val;
+      for (auto lane = 0u; lane < 64u;) {
+        // The first step of a run may carry; the rest do not.
+        composite.advance();
+        auto position = composite.getPositions()[0];
+        auto count = std::min<std::size_t>(runs[position], 64u - lane);
+        if (count > 1u) {
+          composite.advance(count - 1u);
+        }
+
+        auto offsets = _mm512_add_epi8(
+          load(lanes.data()),
+          _mm512_set1_epi8(static_cast<char>(position - lane)));
+        auto out = __m512i{};
+        if (!decoding) {
+          auto inner = load(composite.getInnerComposite().data());
+          out = permute(_mm512_add_epi8(offsets, val), first_forward);
+          out = permute(out, inner);
+          out = permute(_mm512_add_epi8(offsets, out), first_reverse);
+        } else {
+          auto inverse = load(composite.getInnerInverse().data());
+          out = permute(val, first_forward);
+          out = permute(_mm512_sub_epi8(out, offsets), inverse);
+          out = permute(out, first_reverse);
+          out = _mm512_and_si512(_mm512_sub_epi8(out, offsets),
+                                 _mm512_set1_epi8(0x3F));
+        }
+
+        auto mask = count == 64u ? ~__mmask64{0u} :
+                    ((__mmask64{1u} << count) - 1u) << lane;
+        result = _mm512_mask_mov_epi8(result, mask, out);
+        lane += static_cast<unsigned>(count);
+      }
+      return result;
+    }
+
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) void
+    encodeBlockVbmi(std::uint8_t const * bytes, char * text) {
+      auto input = _mm512_maskz_loadu_epi8(block_mask, bytes);
+      auto words = permute(load(split.data()), input);
+      auto indices = _mm512_and_si512(
+        _mm512_maskz_multishift_epi64_epi8(
+          ~__mmask64{0u}, _mm512_set1_epi64(0x3036242A1016040All), words),
+        _mm512_set1_epi8(0x3F));
+      indices = encipherVbmi(indices, false);
+      _mm512_storeu_si512(
+        text, permute(indices, load(base64_alphabet)));
+    }
+
+    // decodeBlockVbmi --
+    // Deciphers 64 characters into 48 bytes. Returns false, having done
+    // nothing, if any character is not in the alphabet (or is padding).
+    //
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) bool
+    decodeBlockVbmi(char const * text, std::uint8_t * bytes) {
+      auto input = _mm512_loadu_si512(text);
+      auto indices = _mm512_permutex2var_epi8(
+        load(detail::base64_index.data()), input,
+        load(detail::base64_index.data() + 64u));
+      if (_mm512_movepi8_mask(_mm512_or_si512(indices, input)) != 0u) {
+        return false;
+      }
+      indices = encipherVbmi(indices, true);
+      auto pairs = _mm512_maddubs_epi16(indices,
+                                        _mm512_set1_epi32(0x01400140));
+      auto groups = _mm512_madd_epi16(pairs, _mm512_set1_epi32(0x00011000));
+      _mm512_mask_storeu_epi8(
+        bytes, block_mask, permute(load(pack.data()), groups));
+      return true;
+    }
+#endif
+
+    CompositeMachine<std::uint8_t, base, rotor_count> composite;
+    std::array<std::uint8_t, base> forward;
+    std::array<std::uint8_t, base> reverse;
+
+    // Steps from each position of the first rotor to the next carry.
+    std::array<std::uint8_t, base> runs;
+  };
+
+  // Base64Codec class deduction guides ----------------------------------------
+
+  template<class T> Base64Codec(T const &) ->
+    Base64Codec<T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_BASE64_HPP
@@ -0,0 +1,1617 @@
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <shared_mutex>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <iomanip>
+#include <utility>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <bitset>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+
+#include "position_index.hpp"
+#include "multilane.hpp"
+#include "reflectorless.hpp"
+#include "composite.hpp"
+#include "base64.hpp"
+#include "datagram.hpp"
+#include "embedded.hpp"
+#include "autotune.hpp"
+#include "keystream.hpp"
+#include "mitm.hpp"
+#include "chain.hpp"
+#include "depth.hpp"
+#include "sigaba.hpp"
+#include "rcu.hpp"
+#include "view.hpp"
+#include "spec.hpp"
+#include "pipe.hpp"
+#include "enigma.hpp"
+#include "perf.hpp"
+#include "jit.hpp"
+#include "util.hpp"
+
+// Benchmark harness -----------------------------------------------------------
+// Each benchmark is a named function which runs a workload over a number of
+// symbols and reports wall time and hardware counters per symbol. Counters
+// which cannot be opened (no PMU, restrictive `perf_event_paranoid`, non-Linux
+// host) are reported as "-".
+//
+// Usage: enigma_bench [--symbols N] [filter...]
+// Only benchmarks whose name contains one of the filters are run.
+
+namespace {
+
+  using namespace enigma;
+  using Clock = std::chrono::steady_clock;
+
+  // Sink for benchmark results, prevents the optimiser discarding workloads.
+  volatile std::size_t sink = 0u;
+
+  struct Options {
+    std::size_t symbols = 1u << 24u;
+    std::vector<std::string> filters;
+  };
+
+  struct Benchmark {
+    char const * name;
+    std::function<void(Options const &)> run;
+  };
+
+  perf::CounterGroup & getCounters() {
+    static auto counters = perf::CounterGroup{};
+    return counters;
+  }
+
+  // measure --
+  // Runs `func` once between counter start and stop and prints a report line
+  // with each figure divided by `symbols`.
+  //
+  template<class Func>
+  void measure(std::string const & name, std::size_t symbols, Func && func) {
+    auto & counters = getCounters();
+    auto begin = Clock::now();
+    counters.start();
+    func();
+    auto sample = counters.stop();
+    auto end = Clock::now();
+
+    auto seconds = std::chrono::duration<double>(end - begin).count();
+    auto per_symbol = [&](perf::Event event) -> std::string {
+      if (!sample.has(event)) {
+        return "-";
+      }
+      auto value = static_cast<double>(sample.get(event)) / symbols;
+      auto text = std::to_string(value);
+      return text.substr(0u, text.find('.') + 4u);
+    };
+
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3)
+              << (seconds * 1e9 / symbols) << " ns"
+              << std::setw(10) << std::setprecision(1)
+              << (symbols / seconds / 1e6) << " M/s";
+
+    for (auto i = 0u; i < perf::event_count; ++i) {
+      auto event = static_cast<perf::Event>(i);
+      std::cout << "  " << perf::getEventName(event) << "="
+                << per_symbol(event);
+    }
+    std::cout << "\n";
+  }
+
+  // Random machine construction --
+
+  template<std::size_t base>
+  std::array<std::uint8_t, base> makeCipher(std::mt19937 & rng) {
+    auto cipher = std::array<std::uint8_t, base>{};
+    std::iota(cipher.begin(), cipher.end(), 0u);
+    std::shuffle(cipher.begin(), cipher.end(), rng);
+    return cipher;
+  }
+
+  template<std::size_t base>
+  std::array<std::uint8_t, base> makeReflector(std::mt19937 & rng) {
+    auto order = makeCipher<base>(rng);
+    auto reflector = std::array<std::uint8_t, base>{};
+    for (auto i = 0u; i + 1u < base; i += 2u) {
+      reflector[order[i]] = order[i + 1u];
+      reflector[order[i + 1u]] = order[i];
+    }
+    if (base % 2u != 0u) {
+      reflector[order[base - 1u]] = order[base - 1u];
+    }
+    return reflector;
+  }
+
+  template<std::size_t base>
+  std::bitset<base> makeNotches(std::mt19937 & rng) {
+    auto notches = std::bitset<base>{};
+    notches.set(rng() % base);
+    return notches;
+  }
+
+  template<std::size_t base, std::size_t ... I>
+  auto makeMachine(std::mt19937 & rng, std::index_sequence<I...>) {
+    using RotorType = Rotor<std::uint8_t, base>;
+    using CipherArray = typename RotorType::CipherArray;
+    using NotchArray = typename RotorType::NotchArray;
+    constexpr auto rotor_count = sizeof...(I);
+
+    auto ciphers = std::array<CipherArray, rotor_count>{
+      ((void)I, makeCipher<base>(rng))...
+    };
+    auto notches = std::array<NotchArray, rotor_count>{
+      ((void)I, makeNotches<base>(rng))...
+    };
+    return EnigmaMachine{
+      std::array<RotorType, rotor_count>{RotorType{ciphers[I], notches[I]}...},
+      makeReflector<base>(rng)
+    };
+  }
+
+  template<std::size_t base, std::size_t rotor_count>
+  auto makeMachine(std::uint32_t seed) {
+    auto rng = std::mt19937{seed};
+    return makeMachine<base>(rng, std::make_index_sequence<rotor_count>{});
+  }
+
+  // makeSigabaBank --
+  // A bank of five rotors with random wiring and positions. Notches are
+  // unused by `SigabaMachine`.
+  //
+  template<std::size_t base>
+  auto makeSigabaBank(std::mt19937 & rng) {
+    using RotorType = Rotor<std::uint8_t, base>;
+    auto make = [&rng] {
+      auto rotor = RotorType{makeCipher<base>(rng), std::bitset<base>{}};
+      rotor.setPosition(rng() % base);
+      return rotor;
+    };
+    return std::array<RotorType, 5u>{make(), make(), make(), make(), make()};
+  }
+
+  auto makeSigaba(std::uint32_t seed) {
+    auto rng = std::mt19937{seed};
+    auto cipher = makeSigabaBank<26u>(rng);
+    auto control = makeSigabaBank<26u>(rng);
+    auto index = makeSigabaBank<10u>(rng);
+    return SigabaMachine<std::uint8_t>{cipher, control, index};
+  }
+
+  template<std::size_t base>
+  std::vector<std::uint8_t> makeInput(std::size_t size) {
+    auto rng = std::mt19937{0x5eedu};
+    auto input = std::vector<std::uint8_t>(size);
+    for (auto & symbol : input) {
+      symbol = static_cast<std::uint8_t>(rng() % base);
+    }
+    return input;
+  }
+
+  // Benchmarks --
+
+  void benchEncodeNext(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto input = makeInput<26u>(options.symbols);
+    auto output = std::vector<std::uint8_t>(input.size());
+
+    measure("EnigmaMachine::encodeNext", input.size(), [&] {
+      for (auto i = 0u; i < input.size(); ++i) {
+        output[i] = machine.encodeNext(input[i]);
+      }
+    });
+    sink = sink + output.back();
+  }
+
+  void benchEncode(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto input = makeInput<26u>(options.symbols);
+    auto output = std::vector<std::uint8_t>(input.size());
+
+    measure("EnigmaMachine::encode", input.size(), [&] {
+      for (auto i = 0u; i < input.size(); ++i) {
+        output[i] = machine.encode(input[i]);
+      }
+    });
+    sink = sink + output.back();
+  }
+
+  void benchGenerator(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto generator = Generator(machine, 0u);
+    auto output = std::vector<std::uint8_t>(options.symbols);
+
+    measure("Generator::operator()", output.size(), [&] {
+      for (auto & value : output) {
+        value = generator();
+      }
+    });
+    sink = sink + output.back();
+  }
+
+  void benchJit(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto reference = machine;
+    auto kernel = JitKernel(machine);
+    auto input = makeInput<26u>(options.symbols);
+    auto expected = input;
+    auto output = input;
+
+    if (!kernel.isCompiled()) {
+      std::cout << "JitKernel unavailable, measuring generic fallback.\n";
+    }
+
+    measure("EnigmaMachine::encodeNext (in place)", input.size(), [&] {
+      for (auto & value : expected) {
+        value = reference.encodeNext(value);
+      }
+    });
+
+    measure("JitKernel::encodeNext", input.size(), [&] {
+      kernel.encodeNext(machine, output.data(), output.size());
+    });
+
+    if (output != expected) {
+      std::cout << "JitKernel output differs from EnigmaMachine!\n";
+    }
+    sink = sink + output.back();
+  }
+
+  template<std::size_t rotor_count>
+  void benchRotorCount(Options const & options) {
+    auto machine = makeMachine<26u, rotor_count>(1u);
+    auto composite = CompositeMachine(machine);
+    auto input = makeInput<26u>(options.symbols);
+    auto expected = std::vector<std::uint8_t>(input.size());
+    auto output = std::vector<std::uint8_t>(input.size());
+    auto suffix = " (" + std::to_string(rotor_count) + " rotors)";
+
+    measure("EnigmaMachine::encodeNext" + suffix, input.size(), [&] {
+      for (auto i = 0u; i < input.size(); ++i) {
+        expected[i] = machine.encodeNext(input[i]);
+      }
+    });
+
+    measure("CompositeMachine::encodeNext" + suffix, input.size(), [&] {
+      composite.encodeNext(input.begin(), input.end(), output.begin());
+    });
+
+    if (output != expected) {
+      std::cout << "CompositeMachine output differs from EnigmaMachine!\n";
+    }
+    sink = sink + output.back();
+  }
+
+  void benchRotors(Options const & options) {
+    benchRotorCount<3u>(options);
+    benchRotorCount<8u>(options);
+    benchRotorCount<16u>(options);
+    benchRotorCount<32u>(options);
+  }
+
+  // measureLatency --
+  // Times `func` individually `count` times and prints percentiles of the
+  // per-call latency. Includes the cost of reading the clock.
+  //
+  template<class Func>
+  void measureLatency(std::string const & name, std::size_t count,
+                      Func && func) {
+    auto latencies = std::vector<double>(count);
+    for (auto & latency : latencies) {
+      auto begin = Clock::now();
+      func();
+      auto end = Clock::now();
+      latency = std::chrono::duration<double, std::nano>(end - begin).count();
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&](double p) {
+      return latencies[static_cast<std::size_t>(p * (count - 1u))];
+    };
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::fixed << std::setprecision(1)
+              << "  p50=" << percentile(0.5) << " ns"
+              << "  p99=" << percentile(0.99) << " ns"
+              << "  p99.9=" << percentile(0.999) << " ns"
+              << "  p99.99=" << percentile(0.9999) << " ns"
+              << "  max=" << latencies.back() << " ns\n";
+  }
+
+  void benchLatency(Options const & options) {
+    auto machine = makeMachine<26u, 32u>(1u);
+    auto immediate = CompositeMachine(machine, RebuildMode::immediate);
+    auto amortised = CompositeMachine(machine, RebuildMode::amortised);
+    auto input = makeInput<26u>(options.symbols);
+    auto i = std::size_t{0u};
+    auto j = std::size_t{0u};
+
+    measureLatency("CompositeMachine immediate (32 rotors)", input.size(),
+      [&] { input[i] = immediate.encodeNext(input[i]); ++i; });
+    measureLatency("CompositeMachine amortised (32 rotors)", input.size(),
+      [&] { input[j] = amortised.encodeNext(input[j]); ++j; });
+
+    sink = sink + input.back();
+  }
+
+  void benchKeystream(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto composite = CompositeMachine(machine);
+    auto keystream = Keystream(machine);
+    auto input = makeInput<26u>(options.symbols);
+    auto expected = std::vector<std::uint8_t>(input.size());
+    auto output = std::vector<std::uint8_t>(input.size());
+
+    measure("CompositeMachine::encodeNext", input.size(), [&] {
+      composite.encodeNext(input.begin(), input.end(), expected.begin());
+    });
+
+    measure("Keystream::encodeNext", input.size(), [&] {
+      keystream.encodeNext(input.begin(), input.end(), output.begin());
+    });
+
+    if (output != expected) {
+      std::cout << "Keystream output differs from CompositeMachine!\n";
+    }
+    sink = sink + output.back();
+  }
+
+  void benchReflectorless(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto input = makeInput<26u>(options.symbols);
+    auto encoded = std::vector<std::uint8_t>(input.size());
+    auto decoded = std::vector<std::uint8_t>(input.size());
+    auto failed = false;
+
+    {
+      auto encoder = CompositeMachine(machine);
+      auto decoder = CompositeMachine(machine);
+      measure("CompositeMachine::encodeNext", input.size(), [&] {
+        encoder.encodeNext(input.begin(), input.end(), encoded.begin());
+      });
+      measure("CompositeMachine::decodeNext", input.size(), [&] {
+        decoder.decodeNext(encoded.begin(), encoded.end(), decoded.begin());
+      });
+      failed = failed || (decoded != input);
+    }
+
+    {
+      auto encoder = ReflectorlessMachine(machine.getRotors());
+      auto decoder = ReflectorlessMachine(machine.getRotors());
+      measure("ReflectorlessMachine::encodeNext", input.size(), [&] {
+        encoder.encodeNext(input.begin(), input.end(), encoded.begin());
+      });
+      measure("ReflectorlessMachine::decodeNext", input.size(), [&] {
+        decoder.decodeNext(encoded.begin(), encoded.end(), decoded.begin());
+      });
+      failed = failed || (decoded != input);
+    }
+
+    if (failed) {
+      std::cout << "Decoding did not restore the input!\n";
+    }
+    sink = sink + decoded.back();
+  }
+
+  void benchSigaba(Options const & options) {
+    auto machine = makeSigaba(1u);
+    auto input = makeInput<26u>(options.symbols);
+    auto reference = std::vector<std::uint8_t>(input.size());
+    auto encoded = std::vector<std::uint8_t>(input.size());
+    auto decoded = std::vector<std::uint8_t>(input.size());
+
+    {
+      auto simulation = machine;
+      measure("SigabaMachine::encodeNext", input.size(), [&] {
+        for (auto i = 0u; i < input.size(); ++i) {
+          reference[i] = simulation.encodeNext(input[i]);
+        }
+      });
+    }
+
+    auto encoder = SigabaEngine(machine);
+    auto decoder = SigabaEngine(machine);
+    measure("SigabaEngine::encodeNext", input.size(), [&] {
+      encoder.encodeNext(input.begin(), input.end(), encoded.begin());
+    });
+    measure("SigabaEngine::decodeNext", input.size(), [&] {
+      decoder.decodeNext(encoded.begin(), encoded.end(), decoded.begin());
+    });
+
+    if (encoded != reference) {
+      std::cout << "SigabaEngine output differs from SigabaMachine!\n";
+    }
+    if (decoded != input) {
+      std::cout << "Decoding did not restore the input!\n";
+    }
+    sink = sink + decoded.back();
+  }
+
+  void benchSpec(Options const & options) {
+    auto input = makeInput<26u>(options.symbols);
+    auto reference = std::vector<std::uint8_t>{};
+    auto output = std::vector<std::uint8_t>(input.size());
+
+    auto text = std::string{
+      "rotor     BDFHJLCPRTXVZNYEIWGAKMUSQO notches W\n"
+      "rotor     AJDKSIRUXBLHWTMCQGZNPYFVOE notches F\n"
+      "rotor     EKMFLGDQVZNTOWYHXUSPAIBRCJ notches R\n"
+      "reflector YRUHQSLDPXNGOKMIEBFZCWVJAT\n"
+    };
+
+    for (auto kernel : {"direct", "composite"}) {
+      auto machine = spec::Machine{spec::parse(text + "kernel " + kernel)};
+      auto name = std::string{"spec::Machine::encodeNext ("} + kernel + ")";
+      measure(name, input.size(), [&] {
+        machine.encodeNext(input.begin(), input.end(), output.begin());
+      });
+      if (reference.empty()) {
+        reference = output;
+      } else if (output != reference) {
+        std::cout << "Kernels differ!\n";
+      }
+    }
+
+    auto machine = spec::Machine{spec::parse(text)};
+    std::cout << "auto kernel: " << spec::getKernelName(machine.getKernel())
+              << "\n";
+    sink = sink + output.back();
+  }
+
+  void benchAutotune(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto input = makeInput<26u>(options.symbols);
+
+    auto expected = input;
+    {
+      auto plain = machine;
+      for (auto & val : expected) {
+        val = plain.encodeNext(val);
+      }
+    }
+
+    for (auto length : {std::size_t{64u}, std::size_t{4096u},
+                        std::size_t{1u} << 20u}) {
+      auto begin = Clock::now();
+      auto tuned = TunedMachine(machine, length);
+      auto seconds = std::chrono::duration<double>(Clock::now() - begin);
+      std::cout << "length " << length << ": "
+                << getBackendName(tuned.getBackend()) << " (tuned in "
+                << std::fixed << std::setprecision(1) << seconds.count() * 1e3
+                << " ms)\n";
+
+      auto output = input;
+      auto name = "TunedMachine (" + std::to_string(length) + ")";
+      measure(name, input.size(), [&] {
+        for (auto i = std::size_t{0u}; i < output.size(); i += length) {
+          auto size = std::min(length, output.size() - i);
+          tuned.encodeNext(output.data() + i, size);
+        }
+      });
+      if (output != expected) {
+        std::cout << "TunedMachine output differs from EnigmaMachine!\n";
+      }
+      sink = sink + output.back();
+    }
+
+    for (auto i = 0u; i < backend_count; ++i) {
+      auto backend = static_cast<Backend>(i);
+      auto output = input;
+      auto begin = Clock::now();
+      auto forced = TunedMachine(machine, backend);
+      auto setup = std::chrono::duration<double>(Clock::now() - begin);
+      auto name = std::string{"backend "} +
+        std::string{getBackendName(backend)} + " (setup " +
+        std::to_string(static_cast<int>(setup.count() * 1e6)) + " us)";
+      measure(name, input.size(), [&] {
+        forced.encodeNext(output.data(), output.size());
+      });
+      if (output != expected) {
+        std::cout << "Backend output differs from EnigmaMachine!\n";
+      }
+    }
+  }
+
+  template<std::size_t ... I>
+  auto makeMachines(std::index_sequence<I...>) {
+    using MachineType = decltype(makeMachine<26u, 3u>(0u));
+    return std::array<MachineType, sizeof...(I)>{
+      makeMachine<26u, 3u>(I + 1u)...
+    };
+  }
+
+  template<std::size_t length>
+  void benchChainOf(std::vector<std::uint8_t> const & input) {
+    auto machines = makeMachines(std::make_index_sequence<length>{});
+    for (auto k = 0u; k < length; ++k) {
+      machines[k].advance(k * 1000u + 7u);
+    }
+
+    auto expected = input;
+    auto output = input;
+    auto suffix = " x" + std::to_string(length);
+
+    {
+      auto sequential = machines;
+      measure("EnigmaMachine::encodeNext" + suffix, input.size(), [&] {
+        for (auto & val : expected) {
+          for (auto & machine : sequential) {
+            val = machine.encodeNext(val);
+          }
+        }
+      });
+    }
+
+    {
+      auto sequential = std::vector<CompositeMachine<std::uint8_t, 26u, 3u>>{};
+      for (auto const & machine : machines) {
+        sequential.emplace_back(machine);
+      }
+      measure("CompositeMachine::encodeNext" + suffix, input.size(), [&] {
+        for (auto & val : output) {
+          for (auto & machine : sequential) {
+            val = machine.encodeNext(val);
+          }
+        }
+      });
+    }
+
+    auto chain = MachineChain(machines);
+    output = input;
+    measure("MachineChain::encodeNext" + suffix, input.size(), [&] {
+      chain.encodeNext(output.begin(), output.end(), output.begin());
+    });
+
+    if (output != expected) {
+      std::cout << "MachineChain output differs from EnigmaMachine!\n";
+    }
+    sink = sink + output.back();
+  }
+
+  void benchChain(Options const & options) {
+    auto input = makeInput<26u>(options.symbols);
+    {
+      auto single = CompositeMachine(makeMachine<26u, 3u>(1u));
+      auto output = input;
+      measure("CompositeMachine::encodeNext x1", input.size(), [&] {
+        single.encodeNext(output.begin(), output.end(), output.begin());
+      });
+      sink = sink + output.back();
+    }
+    benchChainOf<2u>(input);
+    benchChainOf<4u>(input);
+  }
+
+  void benchMitm(Options const &) {
+    auto machine = makeMachine<26u, 5u>(1u);
+    auto rng = std::mt19937{2u};
+    auto key = decltype(machine.getPositions()){};
+    for (auto & position : key) {
+      position = rng() % 26u;
+    }
+
+    auto plain = makeInput<26u>(24u);
+    auto cipher = plain;
+    machine.setPositions(key);
+    for (auto & val : cipher) {
+      val = machine.encodeNext(val);
+    }
+
+    using Seconds = std::chrono::duration<double>;
+    auto report = [](std::string const & name, Seconds seconds,
+                     std::string const & note) {
+      std::cout << std::left << std::setw(40) << name << std::right
+                << std::setw(10) << std::fixed << std::setprecision(3)
+                << seconds.count() * 1e3 << " ms  " << note << "\n";
+    };
+    auto keys = [](std::size_t found) {
+      return std::to_string(found) + " key(s) found";
+    };
+
+    // Every starting position, stopping at the first mismatch.
+    auto begin = Clock::now();
+    auto brute = std::vector<decltype(key)>{};
+    auto candidate = decltype(key){};
+    for (auto state = 0u; state < 26u * 26u * 26u * 26u * 26u; ++state) {
+      for (auto i = 0u, rest = state; i < candidate.size(); ++i) {
+        candidate[i] = rest % 26u;
+        rest /= 26u;
+      }
+      machine.setPositions(candidate);
+      auto i = 0u;
+      while (i < plain.size() && machine.encodeNext(plain[i]) == cipher[i]) {
+        ++i;
+      }
+      if (i == plain.size()) {
+        brute.push_back(candidate);
+      }
+    }
+    report("brute force", Clock::now() - begin, keys(brute.size()));
+
+    for (auto threads : {1u, 4u}) {
+      begin = Clock::now();
+      auto options = MitmOptions{};
+      options.threads = threads;
+      auto search = MitmSearch(machine, 3u, options);
+      auto built = Clock::now();
+      auto found = search.search(plain, cipher);
+      auto end = Clock::now();
+
+      auto name = "MitmSearch build (" + std::to_string(threads) +
+                  " threads)";
+      auto note = "key length " + std::to_string(search.getKeyLength());
+      report(name, built - begin, note);
+      report("MitmSearch search", end - built, keys(found.size()));
+      if (found != brute ||
+          std::find(found.begin(), found.end(), key) == found.end()) {
+        std::cout << "MitmSearch results differ from brute force!\n";
+      }
+    }
+  }
+
+  void benchIndex(Options const &) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    machine.setPositions({});
+    auto rng = std::mt19937{3u};
+    auto key = decltype(machine.getPositions()){};
+    for (auto & position : key) {
+      position = rng() % 26u;
+    }
+
+    auto plain = makeInput<26u>(12u);
+    auto cipher = plain;
+    auto keyed = machine;
+    keyed.setPositions(key);
+    for (auto & val : cipher) {
+      val = keyed.encodeNext(val);
+    }
+
+    using Seconds = std::chrono::duration<double>;
+    auto report = [](std::string const & name, Seconds seconds,
+                     std::string const & note) {
+      std::cout << std::left << std::setw(40) << name << std::right
+                << std::setw(10) << std::fixed << std::setprecision(3)
+                << seconds.count() * 1e3 << " ms  " << note << "\n";
+    };
+    auto keys = [](std::size_t found) {
+      return std::to_string(found) + " key(s) found";
+    };
+
+    // Every starting position, stopping at the first mismatch.
+    auto begin = Clock::now();
+    auto brute = std::vector<decltype(key)>{};
+    auto candidate = decltype(key){};
+    for (auto state = 0u; state < 26u * 26u * 26u; ++state) {
+      for (auto i = 0u, rest = state; i < candidate.size(); ++i) {
+        candidate[i] = rest % 26u;
+        rest /= 26u;
+      }
+      keyed.setPositions(candidate);
+      auto i = 0u;
+      while (i < plain.size() && keyed.encodeNext(plain[i]) == cipher[i]) {
+        ++i;
+      }
+      if (i == plain.size()) {
+        brute.push_back(candidate);
+      }
+    }
+    std::sort(brute.begin(), brute.end());
+    report("brute force", Clock::now() - begin, keys(brute.size()));
+
+    begin = Clock::now();
+    auto index = PositionIndex(machine);
+    auto built = Clock::now();
+    auto const path = std::string{"enigma_bench.index"};
+    index.save(path);
+    auto saved = Clock::now();
+    auto loaded = decltype(index)::load(path, machine);
+    auto mapped = Clock::now();
+    std::remove(path.c_str());
+
+    auto period = "period " + std::to_string(index.getPeriod()) +
+                  (index.isComplete() ? " (complete)" : " (partial)");
+    report("PositionIndex build", built - begin, period);
+    report("PositionIndex save", saved - built, "");
+    report("PositionIndex load", mapped - saved, loaded ? "" : "failed!");
+
+    for (auto const * current : {&index, loaded ? &*loaded : nullptr}) {
+      if (current == nullptr) {
+        continue;
+      }
+      begin = Clock::now();
+      auto found = current->search(plain, cipher);
+      auto end = Clock::now();
+      report("PositionIndex search", end - begin, keys(found.size()));
+      if (found != brute) {
+        std::cout << "PositionIndex results differ from brute force!\n";
+      }
+    }
+  }
+
+  // makeLanguage --
+  // Plaintext with English letter frequencies, so that two plaintexts
+  // coincide at roughly 0.066 against 0.038 for random text.
+  //
+  std::discrete_distribution<unsigned> makeLanguage() {
+    return std::discrete_distribution<unsigned>{
+      82, 15, 28, 43, 127, 22, 20, 61, 70, 2, 8, 40, 24,
+      67, 75, 19, 1, 60, 63, 91, 28, 10, 24, 2, 20, 1
+    };
+  }
+
+  void benchDepth(Options const &) {
+    constexpr auto message_count = 100000u;
+    constexpr auto rows = 20u;
+
+    auto machine = makeMachine<26u, 5u>(1u);
+    auto rng = std::mt19937{4u};
+    auto language = makeLanguage();
+    auto key = decltype(machine.getPositions()){};
+
+    // Messages at random keys, except that message `i + message_count / 2`
+    // is in depth with message `i`, a few steps later, for each searched
+    // row `i`.
+    auto search = DepthSearch<std::uint8_t, 26u>{};
+    auto planted = std::vector<decltype(key)>(rows);
+    auto messages = std::vector<std::vector<std::uint8_t>>(rows + 1u);
+    auto message = std::vector<std::uint8_t>{};
+    for (auto m = 0u; m < message_count; ++m) {
+      for (auto & position : key) {
+        position = rng() % 26u;
+      }
+      if (m >= message_count / 2u && m < message_count / 2u + rows) {
+        machine.setPositions(planted[m - message_count / 2u]);
+        machine.advance(m % 21u);
+      } else {
+        machine.setPositions(key);
+      }
+      if (m < rows) {
+        planted[m] = key;
+      }
+
+      message.resize(60u + rng() % 190u);
+      for (auto & val : message) {
+        val = machine.encodeNext(static_cast<std::uint8_t>(language(rng)));
+      }
+      search.add(message);
+    }
+
+    auto pairs = search.getPairCount(0u, rows);
+    auto begin = Clock::now();
+    auto found = search.search(0u, rows);
+    auto end = Clock::now();
+
+    using Seconds = std::chrono::duration<double>;
+    auto seconds = Seconds(end - begin).count();
+    std::cout << std::left << std::setw(40) << "DepthSearch" << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3)
+              << pairs / seconds / 1e6 << " M pairs/s  ("
+              << pairs << " pairs, " << found.size() << " depths)\n";
+
+    // Short messages rarely reach the threshold, even in depth, so check
+    // that each planted pair scores best at its true offset.
+    auto recovered = 0u;
+    for (auto i = 0u; i < rows; ++i) {
+      auto partner = i + message_count / 2u;
+      auto depth = search.comparePair(i, partner);
+      if (depth.offset == static_cast<std::ptrdiff_t>(partner % 21u)) {
+        ++recovered;
+      }
+    }
+    std::cout << "  planted depths at best offset: " << recovered << " of "
+              << rows << "\n";
+
+    // One row against a plain loop over the same offsets.
+    auto sample = std::vector<std::vector<std::uint8_t>>(4096u);
+    auto small = DepthSearch<std::uint8_t, 26u>{};
+    for (auto & text : sample) {
+      text.resize(60u + rng() % 190u);
+      for (auto & val : text) {
+        val = static_cast<std::uint8_t>(language(rng));
+      }
+      small.add(text);
+    }
+
+    begin = Clock::now();
+    auto fast = std::size_t{0u};
+    for (auto j = 1u; j < sample.size(); ++j) {
+      fast += small.comparePair(0u, j).coincidences;
+    }
+    auto fast_seconds = Seconds(Clock::now() - begin).count();
+
+    begin = Clock::now();
+    auto plain = std::size_t{0u};
+    auto const options = DepthOptions{};
+    for (auto j = 1u; j < sample.size(); ++j) {
+      auto const & a = sample[0];
+      auto const & b = sample[j];
+      auto best = Depth{0u, j, 0, 0u, 0u, 0.0};
+      auto best_score = -1e300;
+      auto span = static_cast<std::ptrdiff_t>(options.max_offset);
+      for (auto offset = -span; offset <= span; ++offset) {
+        auto a_skip = static_cast<std::size_t>(std::max<std::ptrdiff_t>(
+          offset, 0));
+        auto b_skip = static_cast<std::size_t>(std::max<std::ptrdiff_t>(
+          -offset, 0));
+        auto overlap = std::min(a.size() - a_skip, b.size() - b_skip);
+        auto count = std::size_t{0u};
+        for (auto i = 0u; i < overlap; ++i) {
+          count += (a[a_skip + i] == b[b_skip + i]);
+        }
+        auto score = small.getScore(overlap, count);
+        if (overlap >= options.min_overlap && score > best_score) {
+          best_score = score;
+          best.coincidences = count;
+        }
+      }
+      plain += best.coincidences;
+    }
+    auto plain_seconds = Seconds(Clock::now() - begin).count();
+
+    auto rate = [](double seconds) {
+      return 4095.0 / seconds / 1e6;
+    };
+    std::cout << std::left << std::setw(40) << "plain loop (1 row)"
+              << std::right << std::setw(10) << rate(plain_seconds)
+              << " M pairs/s\n"
+              << std::left << std::setw(40) << "DepthSearch (1 row)"
+              << std::right << std::setw(10) << rate(fast_seconds)
+              << " M pairs/s\n";
+    if (fast != plain) {
+      std::cout << "DepthSearch coincidences differ from plain loop!\n";
+    }
+  }
+
+  template<std::size_t lanes>
+  void benchMultiLaneOf(std::size_t symbols) {
+    using MachineType = decltype(makeMachine<26u, 3u>(1u));
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto rng = std::mt19937{lanes};
+    auto positions = std::array<MachineType::PositionArray, lanes>{};
+    auto seeds = std::array<std::uint8_t, lanes>{};
+    for (auto k = 0u; k < lanes; ++k) {
+      for (auto & position : positions[k]) {
+        position = rng() % 26u;
+      }
+      seeds[k] = static_cast<std::uint8_t>(rng() % 26u);
+    }
+
+    auto rounds = symbols / lanes;
+    auto output = std::vector<std::uint8_t>(rounds * lanes);
+    auto generator = MultiLaneGenerator(machine, positions, seeds);
+    auto name = "MultiLaneGenerator<" + std::to_string(lanes) + ">";
+    measure(name, output.size(), [&] {
+      generator.generate(output.data(), rounds);
+    });
+
+    // Each lane against a scalar `Generator` from the same state.
+    auto expected = std::vector<std::uint8_t>(output.size());
+    auto machines = std::vector<MachineType>(lanes, machine);
+    auto scalar = std::vector<Generator<std::uint8_t, 26u, 3u>>{};
+    for (auto k = 0u; k < lanes; ++k) {
+      machines[k].setPositions(positions[k]);
+      scalar.emplace_back(machines[k], seeds[k]);
+    }
+    measure("Generator x " + std::to_string(lanes), expected.size(), [&] {
+      for (auto i = 0u; i < rounds; ++i) {
+        for (auto k = 0u; k < lanes; ++k) {
+          expected[i * lanes + k] = scalar[k]();
+        }
+      }
+    });
+    if (output != expected) {
+      std::cout << "MultiLaneGenerator output differs from Generator!\n";
+    }
+    sink = sink + output.back();
+  }
+
+  void benchMultiLane(Options const & options) {
+    benchMultiLaneOf<8u>(options.symbols);
+    benchMultiLaneOf<16u>(options.symbols);
+    benchMultiLaneOf<32u>(options.symbols);
+    benchMultiLaneOf<64u>(options.symbols);
+    benchMultiLaneOf<12u>(options.symbols);
+  }
+
+  void benchView(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto input = makeInput<26u>(options.symbols);
+    auto expected = input;
+    auto reference = machine;
+    measure("EnigmaMachine::encodeNext", input.size(), [&] {
+      for (auto & val : expected) {
+        val = reference.encodeNext(val);
+      }
+    });
+
+    auto view = EncodedView(machine, input);
+    auto output = std::vector<std::uint8_t>(input.size());
+    measure("EncodedView iteration", input.size(), [&] {
+      std::copy(view.begin(), view.end(), output.begin());
+    });
+    if (output != expected) {
+      std::cout << "EncodedView output differs from EnigmaMachine!\n";
+    }
+
+    // Random reads, each seeking from the start.
+    auto rng = std::mt19937{6u};
+    auto indices = std::vector<std::size_t>(input.size() / 16u);
+    for (auto & index : indices) {
+      index = rng() % input.size();
+    }
+    auto checked = 0u;
+    measure("EncodedView random access", indices.size(), [&] {
+      for (auto index : indices) {
+        checked += (view[index] == expected[index]);
+      }
+    });
+    if (checked != indices.size()) {
+      std::cout << "EncodedView random access differs!\n";
+    }
+
+    // Searching for the last few values, never materialising the ciphertext.
+    auto found = std::size_t{0u};
+    auto const tail = std::min<std::size_t>(expected.size(), 8u);
+    measure("std::search over EncodedView", input.size(), [&] {
+      auto it = std::search(view.begin(), view.end(), expected.end() - tail,
+                            expected.end());
+      found = static_cast<std::size_t>(it - view.begin());
+    });
+    if (found + tail != expected.size()) {
+      std::cout << "std::search over EncodedView found " << found << "\n";
+    }
+
+    // Splitting across threads by seeking to each chunk.
+    for (auto threads : {2u, 4u}) {
+      auto name = "EncodedView copy (" + std::to_string(threads) +
+                  " threads)";
+      measure(name, input.size(), [&] {
+        auto pool = std::vector<std::thread>{};
+        auto chunk = (input.size() + threads - 1u) / threads;
+        for (auto t = 0u; t < threads; ++t) {
+          auto first = std::min(t * chunk, input.size());
+          auto last = std::min(first + chunk, input.size());
+          pool.emplace_back([&, first, last] {
+            auto begin = view.begin() + static_cast<std::ptrdiff_t>(first);
+            auto end = view.begin() + static_cast<std::ptrdiff_t>(last);
+            std::copy(begin, end, output.begin() + first);
+          });
+        }
+        for (auto & thread : pool) {
+          thread.join();
+        }
+      });
+      if (output != expected) {
+        std::cout << "EncodedView output differs when split!\n";
+      }
+    }
+  }
+
+  // Wiring for the embedded profile. A machine refers to its wiring as a
+  // template argument, so it must have static storage; here it is copied
+  // from a random machine at runtime rather than being `constexpr`.
+  embedded::Wiring<std::uint8_t, 26u, 3u> embedded_wiring = {};
+
+  void benchEmbedded(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto input = makeInput<26u>(options.symbols);
+    auto expected = input;
+    auto reference = machine;
+    measure("EnigmaMachine::encodeNext", input.size(), [&] {
+      for (auto & val : expected) {
+        val = reference.encodeNext(val);
+      }
+    });
+
+    embedded_wiring = embedded::makeWiring(machine);
+    auto compact = embedded::Machine<embedded_wiring>{machine.getPositions()};
+    auto output = input;
+    measure("embedded::Machine::encodeNext", input.size(), [&] {
+      for (auto & val : output) {
+        val = compact.encodeNext(val);
+      }
+    });
+    if (output != expected) {
+      std::cout << "embedded::Machine output differs from EnigmaMachine!\n";
+    }
+
+    std::cout << "state bytes: EnigmaMachine " << sizeof(machine)
+              << ", embedded::Machine " << sizeof(compact)
+              << "; wiring bytes " << sizeof(embedded_wiring) << "\n";
+  }
+
+  // Key rotation workload --
+  // Encoder threads encipher their share of the input in batches, each batch
+  // inside a read section of the current key, while a writer replaces the
+  // key every `interval`. A session re-keys (copying the machine and seeking
+  // to its offset) when the key it reads has changed.
+
+  using RotationMachine = decltype(makeMachine<26u, 3u>(0u));
+
+  struct RotationKey {
+    std::uint64_t id;
+    RotationMachine machine;
+  };
+
+  struct RotationStats {
+    std::size_t rotations = 0u;
+    std::size_t rekeys = 0u;
+    double max_batch_seconds = 0.0;
+    double max_rotate_seconds = 0.0;
+  };
+
+  // runRotation --
+  // `read(t, func)` calls `func` with the current key inside a read section
+  // for encoder `t`. `rotate(id)` publishes a new key.
+  //
+  template<class ReadFunc, class RotateFunc>
+  RotationStats runRotation(std::vector<std::uint8_t> const & input,
+                            std::vector<std::uint8_t> & output,
+                            std::size_t threads,
+                            std::chrono::microseconds interval,
+                            ReadFunc && read, RotateFunc && rotate) {
+    constexpr auto batch = std::size_t{4096u};
+    auto stats = RotationStats{};
+    auto done = std::atomic<bool>{false};
+    auto rotator = std::thread{};
+    if (interval.count() > 0) {
+      rotator = std::thread{[&] {
+        while (!done.load(std::memory_order_relaxed)) {
+          std::this_thread::sleep_for(interval);
+          auto begin = Clock::now();
+          rotate(++stats.rotations + 1u);
+          auto seconds = std::chrono::duration<double>(Clock::now() - begin);
+          stats.max_rotate_seconds = std::max(stats.max_rotate_seconds,
+                                              seconds.count());
+        }
+      }};
+    }
+
+    auto slowest = std::vector<double>(threads, 0.0);
+    auto rekeys = std::vector<std::size_t>(threads, 0u);
+    auto pool = std::vector<std::thread>{};
+    auto share = (input.size() + threads - 1u) / threads;
+    for (auto t = 0u; t < threads; ++t) {
+      pool.emplace_back([&, t] {
+        auto first = std::min(t * share, input.size());
+        auto last = std::min(first + share, input.size());
+        auto session = std::optional<RotationKey>{};
+        for (auto i = first; i < last; i += batch) {
+          auto end = std::min(i + batch, last);
+          auto begin = Clock::now();
+          read(t, [&](RotationKey const & key) {
+            if (!session || session->id != key.id) {
+              session.emplace(key);
+              session->machine.advance(i - first);
+              ++rekeys[t];
+            }
+            for (auto j = i; j < end; ++j) {
+              output[j] = session->machine.encodeNext(input[j]);
+            }
+          });
+          auto seconds = std::chrono::duration<double>(Clock::now() - begin);
+          slowest[t] = std::max(slowest[t], seconds.count());
+        }
+      });
+    }
+    for (auto & thread : pool) {
+      thread.join();
+    }
+    done.store(true, std::memory_order_relaxed);
+    if (rotator.joinable()) {
+      rotator.join();
+    }
+
+    stats.max_batch_seconds = *std::max_element(slowest.begin(),
+                                                slowest.end());
+    stats.rekeys = std::accumulate(rekeys.begin(), rekeys.end(),
+                                   std::size_t{0u});
+    return stats;
+  }
+
+  void benchRcu(Options const & options) {
+    constexpr auto threads = std::size_t{2u};
+    auto input = makeInput<26u>(options.symbols);
+    auto output = std::vector<std::uint8_t>(input.size());
+    auto makeKey = [](std::uint64_t id) {
+      return std::make_unique<RotationKey const>(RotationKey{
+        id, makeMachine<26u, 3u>(static_cast<std::uint32_t>(id))});
+    };
+    auto report = [](RotationStats const & stats) {
+      std::cout << "  " << stats.rotations << " rotations, "
+                << stats.rekeys << " session re-keys, slowest batch "
+                << std::fixed << std::setprecision(1)
+                << stats.max_batch_seconds * 1e6 << " us, slowest rotation "
+                << stats.max_rotate_seconds * 1e6 << " us\n";
+    };
+
+    for (auto interval : {0, 50}) {
+      auto period = std::chrono::microseconds{interval};
+      auto suffix = interval == 0 ? std::string{" (no rotation)"} :
+                    " (rotate every " + std::to_string(interval) + " us)";
+
+      // Epoch-based: readers never wait for the writer.
+      {
+        auto cell = RcuCell<RotationKey>{makeKey(1u)};
+        auto readers = std::vector<RcuCell<RotationKey>::Reader>{};
+        for (auto t = 0u; t < threads; ++t) {
+          readers.push_back(cell.makeReader());
+        }
+        auto read = [&](std::size_t t, auto && func) {
+          auto guard = readers[t].lock();
+          func(*guard);
+        };
+        auto rotate = [&](std::uint64_t id) {
+          cell.publish(makeKey(id));
+        };
+        auto stats = RotationStats{};
+        measure("RcuCell" + suffix, input.size(), [&] {
+          stats = runRotation(input, output, threads, period, read, rotate);
+        });
+        report(stats);
+      }
+
+      // Reader-writer lock held for each batch, key swapped under the
+      // exclusive lock.
+      {
+        auto mutex = std::shared_mutex{};
+        auto key = std::unique_ptr<RotationKey const>{makeKey(1u)};
+        auto read = [&](std::size_t, auto && func) {
+          auto lock = std::shared_lock{mutex};
+          func(*key);
+        };
+        auto rotate = [&](std::uint64_t id) {
+          auto next = makeKey(id);
+          auto lock = std::unique_lock{mutex};
+          std::swap(key, next);
+        };
+        auto stats = RotationStats{};
+        measure("std::shared_mutex" + suffix, input.size(), [&] {
+          stats = runRotation(input, output, threads, period, read, rotate);
+        });
+        report(stats);
+      }
+    }
+    sink = sink + output.back();
+  }
+
+  void benchDatagramOf(std::size_t symbols, std::size_t packet_size) {
+    constexpr auto window = std::size_t{32u};
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto plain = makeInput<26u>(symbols);
+    auto cipher = plain;
+    auto sender = machine;
+    for (auto & val : cipher) {
+      val = sender.encodeNext(val);
+    }
+
+    // Packets arrive shuffled within windows of 32, and 1% are lost.
+    using Decoder = decltype(DatagramDecoder(machine));
+    using Datagram = Decoder::Datagram;
+    auto rng = std::mt19937{7u};
+    auto output = std::vector<std::uint8_t>(plain.size(), 0u);
+    auto packets = std::vector<Datagram>{};
+    for (auto offset = std::size_t{0u}; offset < cipher.size();
+         offset += packet_size) {
+      if (rng() % 100u != 0u) {
+        auto size = std::min(packet_size, cipher.size() - offset);
+        packets.push_back({offset, cipher.data() + offset, size,
+                           output.data() + offset});
+      }
+    }
+    for (auto i = 0u; i < packets.size(); i += window) {
+      auto last = std::min<std::size_t>(i + window, packets.size());
+      std::shuffle(packets.begin() + i, packets.begin() + last, rng);
+    }
+
+    auto check = [&](std::string const & name) {
+      for (auto const & packet : packets) {
+        if (!std::equal(packet.out, packet.out + packet.size,
+                        plain.begin() + packet.offset)) {
+          std::cout << name << " output differs!\n";
+          return;
+        }
+      }
+    };
+
+    // One machine, reset and advanced to each packet's offset.
+    auto receiver = machine;
+    measure("EnigmaMachine seek per packet", packets.size(), [&] {
+      for (auto const & packet : packets) {
+        receiver.setPositions(machine.getPositions());
+        receiver.advance(packet.offset);
+        for (auto i = 0u; i < packet.size; ++i) {
+          packet.out[i] = receiver.decodeNext(packet.data[i]);
+        }
+      }
+    });
+    check("EnigmaMachine");
+
+    std::fill(output.begin(), output.end(), 0u);
+    auto decoder = Decoder(machine);
+    measure("DatagramDecoder::decode", packets.size(), [&] {
+      for (auto const & packet : packets) {
+        decoder.decode(packet.offset, packet.data, packet.data + packet.size,
+                       packet.out);
+      }
+    });
+    check("DatagramDecoder::decode");
+    auto unbatched = decoder.getSeekCount();
+
+    std::fill(output.begin(), output.end(), 0u);
+    auto batched = Decoder(machine);
+    measure("DatagramDecoder::decodeBatch (32)", packets.size(), [&] {
+      for (auto i = 0u; i < packets.size(); i += window) {
+        auto last = std::min<std::size_t>(i + window, packets.size());
+        batched.decodeBatch(packets.begin() + i, packets.begin() + last);
+      }
+    });
+    check("DatagramDecoder::decodeBatch");
+
+    std::cout << "  " << packets.size() << " packets of " << packet_size
+              << " symbols, seeks: " << unbatched << " unbatched, "
+              << batched.getSeekCount() << " batched\n";
+  }
+
+  void benchDatagram(Options const & options) {
+    benchDatagramOf(options.symbols / 4u, 16u);
+    benchDatagramOf(options.symbols, 64u);
+  }
+
+  void benchBase64(Options const & options) {
+    auto machine = makeMachine<64u, 3u>(1u);
+    auto symbols = options.symbols / 4u * 4u;
+    auto raw = makeInput<256u>(symbols / 4u * 3u);
+
+    // Separate passes: Base64-encode, map to code points, encipher, map
+    // back, each through a buffer.
+    auto text = std::string{};
+    auto indices = std::vector<std::uint8_t>{};
+    measure("Base64 then CompositeMachine", symbols, [&] {
+      text.resize(symbols);
+      for (auto i = std::size_t{0u}, o = std::size_t{0u}; i < raw.size();
+           i += 3u, o += 4u) {
+        auto group = std::uint32_t{raw[i]} << 16u |
+                     std::uint32_t{raw[i + 1u]} << 8u | raw[i + 2u];
+        for (auto k = 0u; k < 4u; ++k) {
+          text[o + k] = base64_alphabet[(group >> (18u - 6u * k)) & 0x3Fu];
+        }
+      }
+      indices.resize(text.size());
+      for (auto i = std::size_t{0u}; i < text.size(); ++i) {
+        indices[i] = detail::base64_index[
+          static_cast<unsigned char>(text[i])];
+      }
+      auto composite = CompositeMachine(machine);
+      composite.encodeNext(indices.begin(), indices.end(), indices.begin());
+      for (auto i = std::size_t{0u}; i < text.size(); ++i) {
+        text[i] = base64_alphabet[indices[i]];
+      }
+    });
+
+    auto fused = std::string(symbols, '\0');
+    measure("Base64Codec::encode", symbols, [&] {
+      auto codec = Base64Codec(machine);
+      codec.encode(raw.data(), raw.size(), fused.data());
+    });
+    if (fused != text) {
+      std::cout << "Base64Codec::encode output differs!\n";
+    }
+
+    auto plain = std::vector<std::uint8_t>(raw.size());
+    measure("CompositeMachine then Base64 decode", symbols, [&] {
+      for (auto i = std::size_t{0u}; i < text.size(); ++i) {
+        indices[i] = detail::base64_index[
+          static_cast<unsigned char>(fused[i])];
+      }
+      auto composite = CompositeMachine(machine);
+      composite.decodeNext(indices.begin(), indices.end(), indices.begin());
+      for (auto i = std::size_t{0u}; i < text.size(); ++i) {
+        text[i] = base64_alphabet[indices[i]];
+      }
+      for (auto i = std::size_t{0u}, o = std::size_t{0u}; i < text.size();
+           i += 4u, o += 3u) {
+        auto group = std::uint32_t{0u};
+        for (auto k = 0u; k < 4u; ++k) {
+          group = group << 6u | detail::base64_index[
+            static_cast<unsigned char>(text[i + k])];
+        }
+        plain[o] = static_cast<std::uint8_t>(group >> 16u);
+        plain[o + 1u] = static_cast<std::uint8_t>(group >> 8u);
+        plain[o + 2u] = static_cast<std::uint8_t>(group);
+      }
+    });
+    if (plain != raw) {
+      std::cout << "separate decode output differs!\n";
+    }
+
+    std::fill(plain.begin(), plain.end(), 0u);
+    measure("Base64Codec::decode", symbols, [&] {
+      auto codec = Base64Codec(machine);
+      codec.decode(fused.data(), fused.size(), plain.data());
+    });
+    if (plain != raw) {
+      std::cout << "Base64Codec::decode output differs!\n";
+    }
+
+    // Sizes ending in padded groups (one or two trailing bytes), some with
+    // whole vector blocks before them. At 48k + 46 and 48k + 47 bytes the
+    // last 64 characters hold padding, so decoding leaves the vector path
+    // for the scalar one partway through.
+    auto checked = 0u;
+    auto encoded = std::string{};
+    for (auto size : {1u, 2u, 4u, 5u, 46u, 47u, 49u, 50u, 97u, 98u,
+                      48u * 4u + 46u, 48u * 4u + 47u, 48u * 5u + 1u}) {
+      auto bytes = makeInput<256u>(size);
+      auto expected = std::string{};
+      auto composite = CompositeMachine(machine);
+      for (auto i = std::size_t{0u}; i < size; i += 3u) {
+        auto count = std::min<std::size_t>(size - i, 3u);
+        auto group = std::uint32_t{0u};
+        for (auto k = 0u; k < count; ++k) {
+          group |= std::uint32_t{bytes[i + k]} << (16u - 8u * k);
+        }
+        for (auto k = 0u; k < 4u; ++k) {
+          expected += k <= count ? base64_alphabet[composite.encodeNext(
+                                     (group >> (18u - 6u * k)) & 0x3Fu)] :
+                                   '=';
+        }
+      }
+
+      encoded.assign(Base64Codec<3u>::getEncodedSize(size), '\0');
+      Base64Codec(machine).encode(bytes.data(), size, encoded.data());
+      auto decoded = std::vector<std::uint8_t>(
+        Base64Codec<3u>::getDecodedSize(encoded.size()));
+      decoded.resize(Base64Codec(machine).decode(encoded.data(),
+                                                 encoded.size(),
+                                                 decoded.data()));
+      checked += (encoded == expected && decoded == bytes);
+    }
+    if (checked != 13u) {
+      std::cout << "Base64Codec differs on padded tails!\n";
+    }
+
+    // An invalid character in the second block stops the vector path there.
+    encoded[100] = '!';
+    try {
+      Base64Codec(machine).decode(encoded.data(), encoded.size(),
+                                  plain.data());
+      std::cout << "Base64Codec::decode accepted an invalid character!\n";
+    } catch (std::invalid_argument const &) {}
+  }
+
+#if defined(ENIGMA_PIPE_SPLICE)
+
+  // Pipe workload --
+  // Enciphers a file of letters into a pipe drained by a second thread with
+  // `read`, as `enigma stream < file | consumer` would. The consumer sums
+  // the output as 64-bit words, so that it costs little next to the writer.
+  //
+
+  std::uint64_t drainPipe(int fd) {
+    auto buffer = std::vector<std::uint64_t>(1u << 17u);
+    auto sum = std::uint64_t{0u};
+    auto words = std::uint64_t{0u};
+    auto tail = std::size_t{0u};
+    for (;;) {
+      auto * bytes = reinterpret_cast<char *>(buffer.data());
+      auto count = ::read(fd, bytes + tail, buffer.size() * 8u - tail);
+      if (count <= 0) {
+        break;
+      }
+      tail += static_cast<std::size_t>(count);
+      for (auto i = 0u; i < tail / 8u; ++i, ++words) {
+        sum += buffer[i] * (2u * words + 1u);
+      }
+      std::memmove(bytes, bytes + tail / 8u * 8u, tail % 8u);
+      tail %= 8u;
+    }
+    return sum;
+  }
+
+  // NullMachine struct --
+  // Leaves symbols unchanged, leaving the cost of moving the bytes.
+  //
+  struct NullMachine {
+    std::uint8_t encodeNext(std::uint8_t val) {
+      return val;
+    }
+
+    void advance() {}
+  };
+
+  template<class Func>
+  std::uint64_t measurePipe(std::string const & name, int input_fd,
+                            std::size_t size, Func && func) {
+    int fds[2];
+    if (::pipe(fds) != 0 || ::lseek(input_fd, 0, SEEK_SET) != 0) {
+      std::cout << name << ": cannot set up pipe\n";
+      return 0u;
+    }
+    auto sum = std::uint64_t{0u};
+    measure(name, size, [&] {
+      auto consumer = std::thread{[&] {
+        sum = drainPipe(fds[0]);
+      }};
+      func(fds[1]);
+      ::close(fds[1]);
+      consumer.join();
+    });
+    ::close(fds[0]);
+    return sum;
+  }
+
+  void benchPipe(Options const & options) {
+    auto machine = makeMachine<26u, 3u>(1u);
+    auto text = std::vector<char>(options.symbols);
+    auto input = makeInput<26u>(text.size());
+    for (auto i = std::size_t{0u}; i < text.size(); ++i) {
+      text[i] = static_cast<char>((i % 64u == 63u) ? '\n' : 'A' + input[i]);
+    }
+
+    auto * file = std::tmpfile();
+    if (file == nullptr ||
+        std::fwrite(text.data(), 1u, text.size(), file) != text.size() ||
+        std::fflush(file) != 0) {
+      std::cout << "pipe: cannot write input file\n";
+      return;
+    }
+    auto input_fd = ::fileno(file);
+    auto proc_path = [](int fd) {
+      return "/proc/self/fd/" + std::to_string(fd);
+    };
+
+    // No I/O: the cost of enciphering alone.
+    auto expected = text;
+    auto reference = machine;
+    measure("encodeBytes (in memory)", text.size(), [&] {
+      encodeBytes(reference, expected.data(), expected.size());
+    });
+
+    auto sums = std::vector<std::uint64_t>{};
+    auto spliced = false;
+    auto run = [&](std::string const & name, auto const & machine) {
+      sums.push_back(measurePipe(
+        "encodeStream (iostream)" + name, input_fd, text.size(),
+        [&](int fd) {
+          auto encoder = machine;
+          auto is = std::ifstream{proc_path(input_fd), std::ios::binary};
+          auto os = std::ofstream{proc_path(fd), std::ios::binary};
+          encodeStream(encoder, is, os);
+        }));
+
+      sums.push_back(measurePipe(
+        "read/write (64 KiB)" + name, input_fd, text.size(), [&](int fd) {
+          auto encoder = machine;
+          auto buffer = std::vector<char>(1u << 16u);
+          for (;;) {
+            auto count = detail::readFull(input_fd, buffer.data(),
+                                          buffer.size());
+            if (count == 0u) {
+              break;
+            }
+            encodeBytes(encoder, buffer.data(), count);
+            detail::writeFull(fd, buffer.data(), count);
+          }
+        }));
+
+      sums.push_back(measurePipe(
+        "encodePipe (vmsplice)" + name, input_fd, text.size(), [&](int fd) {
+          auto encoder = machine;
+          spliced = encodePipe(encoder, input_fd, fd).spliced;
+        }));
+    };
+
+    run("", machine);
+    run(", composite", CompositeMachine(machine));
+    auto check = sums;
+    sums.clear();
+    run(", no cipher", NullMachine{});
+
+    auto words = std::vector<std::uint64_t>(text.size() / 8u);
+    std::memcpy(words.data(), expected.data(), words.size() * 8u);
+    auto sum = std::uint64_t{0u};
+    for (auto i = std::size_t{0u}; i < words.size(); ++i) {
+      sum += words[i] * (2u * i + 1u);
+    }
+    for (auto other : check) {
+      if (other != sum) {
+        std::cout << "pipe output differs!\n";
+      }
+    }
+    if (!spliced) {
+      std::cout << "  output was not spliced\n";
+    }
+    std::fclose(file);
+  }
+
+#else
+
+  void benchPipe(Options const &) {
+    std::cout << "pipe: not supported on this platform\n";
+  }
+
+#endif
+
+  Benchmark const benchmarks[] = {
+    {"encodeNext", benchEncodeNext},
+    {"encode", benchEncode},
+    {"generator", benchGenerator},
+    {"jit", benchJit},
+    {"rotors", benchRotors},
+    {"latency", benchLatency},
+    {"keystream", benchKeystream},
+    {"reflectorless", benchReflectorless},
+    {"sigaba", benchSigaba},
+    {"spec", benchSpec},
+    {"autotune", benchAutotune},
+    {"chain", benchChain},
+    {"mitm", benchMitm},
+    {"index", benchIndex},
+    {"depth", benchDepth},
+    {"multilane", benchMultiLane},
+    {"view", benchView},
+    {"embedded", benchEmbedded},
+    {"rcu", benchRcu},
+    {"datagram", benchDatagram},
+    {"pipe", benchPipe},
+    {"base64", benchBase64}
+  };
+
+  Options parseOptions(int argc, char ** argv) {
+    auto options = Options{};
+    for (auto i = 1; i < argc; ++i) {
+      auto arg = std::string{argv[i]};
+      if (arg == "--symbols" && i + 1 < argc) {
+        options.symbols = std::strtoull(argv[++i], nullptr, 10);
+      } else {
+        options.filters.push_back(arg);
+      }
+    }
+    options.symbols = std::max<std::size_t>(options.symbols, 1u);
+    return options;
+  }
+
+  bool isSelected(Options const & options, std::string const & name) {
+    if (options.filters.empty()) {
+      return true;
+    }
+    return std::any_of(options.filters.begin(), options.filters.end(),
+      [&](auto const & filter) {
+        return name.find(filter) != std::string::npos;
+      });
+  }
+
+}
+
+// -----------------------------------------------------------------------------
+
+int main(int argc, char ** argv) {
+
+  auto options = parseOptions(argc, argv);
+
+  if (!getCounters().isEnabled()) {
+    std::cout << "Hardware counters unavailable, reporting wall time only.\n";
+  }
+
+  for (auto const & benchmark : benchmarks) {
+    if (isSelected(options, benchmark.name)) {
+      benchmark.run(options);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,224 @@
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <algorithm>
+#include <exception>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <new>
+
+#include "capi.h"
+#include "spec.hpp"
+
+// enigma_machine struct -------------------------------------------------------
+
+struct enigma_machine {
+  enigma::spec::Machine machine;
+};
+
+namespace {
+
+  using enigma::spec::Spec;
+  using enigma::spec::WheelSpec;
+
+  bool isPermutation(std::uint8_t const * values, std::size_t size) {
+    auto seen = std::vector<bool>(size, false);
+    for (auto i = std::size_t{0u}; i < size; ++i) {
+      if (values[i] >= size || seen[values[i]]) {
+        return false;
+      }
+      seen[values[i]] = true;
+    }
+    return true;
+  }
+
+  // makeSpec --
+  // Converts and validates `wiring`. Returns false if it is malformed.
+  //
+  bool makeSpec(enigma_wiring const & wiring, Spec & spec) {
+    auto const base = wiring.base;
+    if (base < 2u || base > ENIGMA_MAX_BASE || wiring.rotor_count == 0u ||
+        wiring.rotors == nullptr || wiring.notches == nullptr) {
+      return false;
+    }
+
+    // One distinct byte per symbol; the alphabet is never printed.
+    spec.alphabet.clear();
+    for (auto i = std::size_t{0u}; i < base; ++i) {
+      spec.alphabet.push_back(static_cast<char>(i));
+    }
+
+    for (auto r = std::size_t{0u}; r < wiring.rotor_count; ++r) {
+      auto const * rotor = wiring.rotors + r * base;
+      auto const * notches = wiring.notches + r * base;
+      if (!isPermutation(rotor, base)) {
+        return false;
+      }
+
+      auto wheel = WheelSpec{};
+      wheel.wiring.assign(rotor, rotor + base);
+      for (auto i = std::size_t{0u}; i < base; ++i) {
+        if (notches[i] != 0u) {
+          wheel.notches.push_back(static_cast<std::uint8_t>(i));
+        }
+      }
+      if (wiring.positions != nullptr) {
+        if (wiring.positions[r] >= base) {
+          return false;
+        }
+        wheel.position = wiring.positions[r];
+      }
+      spec.wheels.push_back(std::move(wheel));
+    }
+
+    if (wiring.reflector != nullptr) {
+      if (!isPermutation(wiring.reflector, base)) {
+        return false;
+      }
+      spec.reflector.assign(wiring.reflector, wiring.reflector + base);
+    }
+
+    if (wiring.plugboard != nullptr) {
+      auto const * plugboard = wiring.plugboard;
+      if (!isPermutation(plugboard, base)) {
+        return false;
+      }
+      for (auto i = std::size_t{0u}; i < base; ++i) {
+        if (plugboard[plugboard[i]] != i) {
+          return false;
+        }
+      }
+      spec.plugboard.assign(plugboard, plugboard + base);
+    }
+    return true;
+  }
+
+  // transcode --
+  // Enciphers, or with `decode` deciphers, `data` in place after checking
+  // every symbol.
+  //
+  int transcode(enigma_machine * handle, std::uint8_t * data,
+                std::size_t size, bool decode) {
+    if (handle == nullptr || (data == nullptr && size > 0u)) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    auto & machine = handle->machine;
+    auto const top = std::max_element(data, data + size);
+    if (top != data + size && *top >= machine.getBase()) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    if (decode) {
+      machine.decodeNext(data, data + size, data);
+    } else {
+      machine.encodeNext(data, data + size, data);
+    }
+    return ENIGMA_OK;
+  }
+
+  int transcodeBatch(enigma_job * jobs, std::size_t count, bool decode) {
+    if (jobs == nullptr && count > 0u) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    auto result = ENIGMA_OK;
+    for (auto i = std::size_t{0u}; i < count; ++i) {
+      auto & job = jobs[i];
+      job.status = transcode(job.machine, job.data, job.size, decode);
+      if (job.status != ENIGMA_OK) {
+        result = job.status;
+      }
+    }
+    return result;
+  }
+
+}
+
+// C interface -----------------------------------------------------------------
+
+extern "C" {
+
+  int enigma_create(enigma_wiring const * wiring, enigma_machine ** machine) {
+    if (wiring == nullptr || machine == nullptr) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    *machine = nullptr;
+
+    try {
+      auto spec = Spec{};
+      if (!makeSpec(*wiring, spec)) {
+        return ENIGMA_ERROR_ARGUMENT;
+      }
+      *machine = new enigma_machine{enigma::spec::Machine{spec}};
+      return ENIGMA_OK;
+    } catch (std::bad_alloc const &) {
+      return ENIGMA_ERROR_MEMORY;
+    } catch (std::exception const &) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+  }
+
+  void enigma_destroy(enigma_machine * machine) {
+    delete machine;
+  }
+
+  size_t enigma_get_base(enigma_machine const * machine) {
+    return machine != nullptr ? machine->machine.getBase() : 0u;
+  }
+
+  size_t enigma_get_rotor_count(enigma_machine const * machine) {
+    return machine != nullptr ? machine->machine.getRotorCount() : 0u;
+  }
+
+  int enigma_get_positions(enigma_machine const * machine,
+                           size_t * positions) {
+    if (machine == nullptr || positions == nullptr) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    for (auto r = std::size_t{0u}; r < machine->machine.getRotorCount(); ++r) {
+      positions[r] = machine->machine.getRotorPosition(r);
+    }
+    return ENIGMA_OK;
+  }
+
+  int enigma_set_positions(enigma_machine * machine,
+                           size_t const * positions) {
+    if (machine == nullptr || positions == nullptr) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    auto const count = machine->machine.getRotorCount();
+    auto const base = machine->machine.getBase();
+    auto invalid = [base](std::size_t position) { return position >= base; };
+    if (std::any_of(positions, positions + count, invalid)) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    machine->machine.setRotorPositions(positions);
+    return ENIGMA_OK;
+  }
+
+  int enigma_seek(enigma_machine * machine, uint64_t steps) {
+    if (machine == nullptr) {
+      return ENIGMA_ERROR_ARGUMENT;
+    }
+    machine->machine.advance(static_cast<std::size_t>(steps));
+    return ENIGMA_OK;
+  }
+
+  int enigma_encode(enigma_machine * machine, uint8_t * data, size_t size) {
+    return transcode(machine, data, size, false);
+  }
+
+  int enigma_encode_batch(enigma_job * jobs, size_t count) {
+    return transcodeBatch(jobs, count, false);
+  }
+
+  int enigma_decode(enigma_machine * machine, uint8_t * data, size_t size) {
+    return transcode(machine, data, size, true);
+  }
+
+  int enigma_decode_batch(enigma_job * jobs, size_t count) {
+    return transcodeBatch(jobs, count, true);
+  }
+
+}
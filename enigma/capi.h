@@ -0,0 +1,150 @@
+#ifndef ENIGMA_CAPI_H
+#define ENIGMA_CAPI_H
+
+// C interface -----------------------------------------------------------------
+// A C ABI over the runtime machine (`enigma::spec::Machine`), for callers in
+// other languages. Machines are opaque handles. Symbols are bytes in
+// `[0, base)`, enciphered in place in caller buffers, so no data is copied
+// across the interface and no call but `enigma_create` allocates.
+//
+// Every wheel is a stepping rotor, the first stepping fastest, with the
+// same stepping and ciphers as `EnigmaMachine`: each symbol advances the
+// machine and then passes through the plugboard, rotors, reflector, rotors
+// in reverse and plugboard again.
+//
+// Thread safety: a handle may be used by one thread at a time; calls on
+// distinct handles may run concurrently. `enigma_encode_batch` must not be
+// given the same handle twice, nor a handle in use by another thread; nor
+// may `enigma_decode_batch`.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CMake defines `enigma_c_EXPORTS` while building the shared library.
+#if defined(_WIN32) && defined(enigma_c_EXPORTS)
+#define ENIGMA_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define ENIGMA_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define ENIGMA_API __attribute__((visibility("default")))
+#else
+#define ENIGMA_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Status codes.
+#define ENIGMA_OK 0
+#define ENIGMA_ERROR_ARGUMENT 1
+#define ENIGMA_ERROR_MEMORY 2
+
+// Largest number of symbols per wheel.
+#define ENIGMA_MAX_BASE 254
+
+typedef struct enigma_machine enigma_machine;
+
+// enigma_wiring --
+// `base` - Symbols per wheel, 2 to `ENIGMA_MAX_BASE`.
+// `rotor_count` - Number of rotors, at least 1.
+// `rotors` - `rotor_count * base` bytes: the forward wiring of each rotor in
+//            turn, each a permutation of `[0, base)`.
+// `notches` - `rotor_count * base` bytes: non-zero where a rotor carries
+//             into the next on reaching that position.
+// `reflector` - `base` bytes, a permutation; or NULL for none, in which case
+//               symbols pass through the rotors once.
+// `plugboard` - `base` bytes, a permutation which is its own inverse; or
+//               NULL for none.
+// `positions` - `rotor_count` starting positions; or NULL for all zero.
+//
+typedef struct enigma_wiring {
+  size_t base;
+  size_t rotor_count;
+  uint8_t const * rotors;
+  uint8_t const * notches;
+  uint8_t const * reflector;
+  uint8_t const * plugboard;
+  size_t const * positions;
+} enigma_wiring;
+
+// enigma_job --
+// One buffer of `size` symbols at `data`, enciphered or deciphered in place
+// by `machine`. `status` is set by `enigma_encode_batch` or
+// `enigma_decode_batch`.
+//
+typedef struct enigma_job {
+  enigma_machine * machine;
+  uint8_t * data;
+  size_t size;
+  int status;
+} enigma_job;
+
+// enigma_create --
+// Builds a machine from `wiring`, which is copied. On success stores the
+// handle in `*machine`.
+//
+ENIGMA_API int enigma_create(enigma_wiring const * wiring,
+                             enigma_machine ** machine);
+
+// enigma_destroy --
+// Frees `machine`. NULL is ignored.
+//
+ENIGMA_API void enigma_destroy(enigma_machine * machine);
+
+ENIGMA_API size_t enigma_get_base(enigma_machine const * machine);
+
+ENIGMA_API size_t enigma_get_rotor_count(enigma_machine const * machine);
+
+// enigma_get_positions --
+// Writes the `rotor_count` rotor positions to `positions`.
+//
+ENIGMA_API int enigma_get_positions(enigma_machine const * machine,
+                                    size_t * positions);
+
+// enigma_set_positions --
+// Sets the `rotor_count` rotor positions from `positions`, without
+// turnovers.
+//
+ENIGMA_API int enigma_set_positions(enigma_machine * machine,
+                                    size_t const * positions);
+
+// enigma_seek --
+// Advances by `steps`, as if that many symbols had been enciphered. Costs
+// the same for any distance.
+//
+ENIGMA_API int enigma_seek(enigma_machine * machine, uint64_t steps);
+
+// enigma_encode --
+// Enciphers the `size` symbols at `data` in place, advancing before each.
+// If any symbol is out of range nothing is changed.
+//
+ENIGMA_API int enigma_encode(enigma_machine * machine, uint8_t * data,
+                             size_t size);
+
+// enigma_encode_batch --
+// Runs `enigma_encode` for each of `count` jobs, in order, on the calling
+// thread. Returns `ENIGMA_OK` if every job succeeded.
+//
+ENIGMA_API int enigma_encode_batch(enigma_job * jobs, size_t count);
+
+// enigma_decode --
+// Inverse of `enigma_encode`: deciphers the `size` symbols at `data` in
+// place, advancing before each, so that a machine at the same starting
+// positions recovers what `enigma_encode` enciphered. If any symbol is out
+// of range nothing is changed.
+//
+ENIGMA_API int enigma_decode(enigma_machine * machine, uint8_t * data,
+                             size_t size);
+
+// enigma_decode_batch --
+// Runs `enigma_decode` for each of `count` jobs, as `enigma_encode_batch`.
+//
+ENIGMA_API int enigma_decode_batch(enigma_job * jobs, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENIGMA_CAPI_H
@@ -0,0 +1,204 @@
+// C interface benchmark -------------------------------------------------------
+// Measures the cost of crossing the C interface: the same symbols enciphered
+// in one call, one call per symbol, per-session calls and one batch call.
+//
+// Usage: enigma_capi_bench [--symbols N]
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "capi.h"
+
+enum {
+  base = 26,
+  rotor_count = 3,
+  session_count = 1024,
+  session_size = 64
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// nextRandom --
+// Small deterministic generator, so runs are comparable.
+//
+static uint32_t nextRandom(uint32_t * state) {
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8u;
+}
+
+static void makePermutation(uint8_t * values, uint32_t * state) {
+  for (int i = 0; i < base; ++i) {
+    values[i] = (uint8_t)i;
+  }
+  for (int i = base - 1; i > 0; --i) {
+    int j = (int)(nextRandom(state) % (uint32_t)(i + 1));
+    uint8_t tmp = values[i];
+    values[i] = values[j];
+    values[j] = tmp;
+  }
+}
+
+static enigma_machine * makeMachine(uint32_t seed) {
+  uint8_t rotors[rotor_count * base];
+  uint8_t notches[rotor_count * base];
+  uint8_t reflector[base];
+  uint8_t order[base];
+  size_t positions[rotor_count];
+  uint32_t state = 1u;
+
+  memset(notches, 0, sizeof(notches));
+  for (int r = 0; r < rotor_count; ++r) {
+    makePermutation(rotors + r * base, &state);
+    notches[r * base + (int)(nextRandom(&state) % base)] = 1u;
+    positions[r] = (seed + (uint32_t)r * 7u) % base;
+  }
+  makePermutation(order, &state);
+  for (int i = 0; i < base; i += 2) {
+    reflector[order[i]] = order[i + 1];
+    reflector[order[i + 1]] = order[i];
+  }
+
+  enigma_wiring wiring = {
+    base, rotor_count, rotors, notches, reflector, NULL, positions
+  };
+  enigma_machine * machine = NULL;
+  if (enigma_create(&wiring, &machine) != ENIGMA_OK) {
+    fprintf(stderr, "enigma_create failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return machine;
+}
+
+static void report(char const * name, size_t symbols, double seconds) {
+  printf("%-40s%10.3f ns\n", name, seconds * 1e9 / (double)symbols);
+}
+
+int main(int argc, char ** argv) {
+  size_t symbols = (size_t)1u << 22u;
+  for (int i = 1; i + 1 < argc; ++i) {
+    if (strcmp(argv[i], "--symbols") == 0) {
+      symbols = (size_t)strtoull(argv[++i], NULL, 10);
+    }
+  }
+  if (symbols == 0u) {
+    fprintf(stderr, "--symbols must be non-zero\n");
+    return EXIT_FAILURE;
+  }
+
+  uint8_t * input = malloc(symbols);
+  uint8_t * data = malloc(symbols);
+  uint8_t * expected = malloc(symbols);
+  if (input == NULL || data == NULL || expected == NULL) {
+    return EXIT_FAILURE;
+  }
+  uint32_t state = 7u;
+  for (size_t i = 0u; i < symbols; ++i) {
+    input[i] = (uint8_t)(nextRandom(&state) % base);
+  }
+
+  // One call for every symbol at once.
+  enigma_machine * machine = makeMachine(0u);
+  memcpy(expected, input, symbols);
+  double begin = now();
+  enigma_encode(machine, expected, symbols);
+  report("enigma_encode (one call)", symbols, now() - begin);
+  enigma_destroy(machine);
+
+  // One call per symbol.
+  machine = makeMachine(0u);
+  memcpy(data, input, symbols);
+  begin = now();
+  for (size_t i = 0u; i < symbols; ++i) {
+    enigma_encode(machine, data + i, 1u);
+  }
+  report("enigma_encode (one call per symbol)", symbols, now() - begin);
+  enigma_destroy(machine);
+  if (memcmp(data, expected, symbols) != 0) {
+    printf("per-symbol output differs!\n");
+  }
+
+  // Deciphering from the same starting positions recovers the input.
+  machine = makeMachine(0u);
+  memcpy(data, expected, symbols);
+  begin = now();
+  enigma_decode(machine, data, symbols);
+  report("enigma_decode (one call)", symbols, now() - begin);
+  enigma_destroy(machine);
+  if (memcmp(data, input, symbols) != 0) {
+    printf("decoded output differs from input!\n");
+  }
+
+  // Many short sessions, one call each, then as one batch.
+  enigma_machine * sessions[session_count];
+  enigma_job jobs[session_count];
+  size_t rounds = symbols / (session_count * session_size);
+  rounds = rounds > 0u ? rounds : 1u;
+  uint8_t * buffer = malloc(session_count * session_size);
+  if (buffer == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int s = 0; s < session_count; ++s) {
+      sessions[s] = makeMachine((uint32_t)s);
+      jobs[s].machine = sessions[s];
+      jobs[s].data = buffer + s * session_size;
+      jobs[s].size = session_size;
+    }
+    // The input is repeated if it is shorter than the buffer.
+    for (size_t i = 0u; i < session_count * session_size; ++i) {
+      buffer[i] = input[i % symbols];
+    }
+
+    int failed = 0;
+    begin = now();
+    for (size_t r = 0u; r < rounds; ++r) {
+      if (pass == 0) {
+        for (int s = 0; s < session_count; ++s) {
+          failed |= enigma_encode(sessions[s], jobs[s].data, jobs[s].size) !=
+                    ENIGMA_OK;
+        }
+      } else {
+        failed |= enigma_encode_batch(jobs, session_count) != ENIGMA_OK;
+      }
+    }
+    report(pass == 0 ? "enigma_encode (per session, 64 symbols)" :
+                       "enigma_encode_batch (1024 x 64 symbols)",
+           rounds * session_count * session_size, now() - begin);
+    if (failed) {
+      printf("%s failed!\n", pass == 0 ? "enigma_encode" :
+                                          "enigma_encode_batch");
+    }
+
+    for (int s = 0; s < session_count; ++s) {
+      enigma_destroy(sessions[s]);
+    }
+  }
+
+  // Seeking, from the start, to each offset.
+  machine = makeMachine(0u);
+  size_t const start[rotor_count] = {0u, 7u, 14u};
+  size_t const seeks = 1u << 20u;
+  begin = now();
+  for (size_t i = 0u; i < seeks; ++i) {
+    enigma_set_positions(machine, start);
+    enigma_seek(machine, (uint64_t)i * 7919u);
+  }
+  report("enigma_set_positions + enigma_seek", seeks, now() - begin);
+  enigma_destroy(machine);
+
+  free(buffer);
+  free(expected);
+  free(data);
+  free(input);
+  return EXIT_SUCCESS;
+}
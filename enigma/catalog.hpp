@@ -0,0 +1,180 @@
+#ifndef ENIGMA_CATALOG_HPP
+#define ENIGMA_CATALOG_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <bitset>
+#include <array>
+
+namespace enigma::catalog {
+
+  // Historical wiring catalog -------------------------------------------------
+  // The rotors and reflectors of the Enigma I, M3 and M4, parsed from their
+  // letter strings at compile time. Each rotor carries its reverse cipher, so
+  // a `Rotor` built from an entry (see the `Rotor` constructor taking both
+  // ciphers) copies its tables rather than computing them, and
+  // `embedded::makeRotorTables` accepts an entry's tables directly.
+  //
+  // Notches follow `Rotor`: a notch is the position at which the next rotor
+  // is knocked on, which is the letter after the historical turnover letter
+  // (rotor I turns over at Q, so its notch is at R). Beta and Gamma, the M4
+  // fourth wheels, have no notches. Reflectors are involutions without fixed
+  // points.
+  // Source:
+  // https://en.wikipedia.org/wiki/Enigma_rotor_details#Rotor_wiring_tables
+  //
+
+  using Index = std::uint8_t;
+  inline constexpr std::size_t base = 26u;
+  using CipherArray = std::array<Index, base>;
+  using NotchArray = std::bitset<base>;
+
+  struct RotorWiring {
+    CipherArray forward;
+    CipherArray reverse;
+    NotchArray notches;
+  };
+
+  namespace detail {
+
+    [[nodiscard]] constexpr Index parseLetter(char letter) {
+      return static_cast<Index>(letter - 'A');
+    }
+
+    [[nodiscard]] constexpr CipherArray parseCipher(std::string_view letters) {
+      auto cipher = CipherArray{};
+      for (auto i = std::size_t{0u}; i < base; ++i) {
+        cipher[i] = parseLetter(letters[i]);
+      }
+      return cipher;
+    }
+
+    [[nodiscard]] constexpr CipherArray invert(CipherArray const & cipher) {
+      auto inverse = CipherArray{};
+      for (auto i = std::size_t{0u}; i < base; ++i) {
+        inverse[cipher[i]] = static_cast<Index>(i);
+      }
+      return inverse;
+    }
+
+    [[nodiscard]] constexpr NotchArray parseNotches(std::string_view letters) {
+      auto bits = 0ull;
+      for (auto letter : letters) {
+        bits |= 1ull << parseLetter(letter);
+      }
+      return NotchArray{bits};
+    }
+
+    [[nodiscard]] constexpr RotorWiring
+    makeRotor(std::string_view letters, std::string_view notches) {
+      auto forward = parseCipher(letters);
+      return RotorWiring{forward, invert(forward), parseNotches(notches)};
+    }
+
+    // isPermutation --
+    // True if `cipher` holds each code point exactly once.
+    //
+    [[nodiscard]] constexpr bool isPermutation(CipherArray const & cipher) {
+      auto seen = 0ull;
+      for (auto val : cipher) {
+        if (val >= base) {
+          return false;
+        }
+        seen |= 1ull << val;
+      }
+      return seen == (1ull << base) - 1u;
+    }
+
+    // isValid --
+    // True if the forward cipher is a permutation and the reverse cipher is
+    // its inverse.
+    //
+    [[nodiscard]] constexpr bool isValid(RotorWiring const & rotor) {
+      if (!isPermutation(rotor.forward)) {
+        return false;
+      }
+      for (auto i = std::size_t{0u}; i < base; ++i) {
+        if (rotor.reverse[rotor.forward[i]] != i) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // isReflector --
+    // True if `cipher` is its own inverse and maps no code point to itself.
+    //
+    [[nodiscard]] constexpr bool isReflector(CipherArray const & cipher) {
+      if (!isPermutation(cipher)) {
+        return false;
+      }
+      for (auto i = std::size_t{0u}; i < base; ++i) {
+        if (cipher[i] == i || cipher[cipher[i]] != i) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  }
+
+  // Rotors --
+
+  inline constexpr auto rotorI = detail::makeRotor(
+    "EKMFLGDQVZNTOWYHXUSPAIBRCJ", "R");
+  inline constexpr auto rotorII = detail::makeRotor(
+    "AJDKSIRUXBLHWTMCQGZNPYFVOE", "F");
+  inline constexpr auto rotorIII = detail::makeRotor(
+    "BDFHJLCPRTXVZNYEIWGAKMUSQO", "W");
+  inline constexpr auto rotorIV = detail::makeRotor(
+    "ESOVPZJAYQUIRHXLNFTGKDCMWB", "K");
+  inline constexpr auto rotorV = detail::makeRotor(
+    "VZBRGITYUPSDNHLXAWMJQOFECK", "A");
+  inline constexpr auto rotorVI = detail::makeRotor(
+    "JPGVOUMFYQBENHZRDKASXLICTW", "AN");
+  inline constexpr auto rotorVII = detail::makeRotor(
+    "NZJHGRCXMYSWBOUFAIVLPEKQDT", "AN");
+  inline constexpr auto rotorVIII = detail::makeRotor(
+    "FKQHTLXOCBJSPDZRAMEWNIUYGV", "AN");
+  inline constexpr auto rotorBeta = detail::makeRotor(
+    "LEYJVCNIXWPBQMDRTAKZGFUHOS", "");
+  inline constexpr auto rotorGamma = detail::makeRotor(
+    "FSOKANUERHMBTIPCWLJDGXZQYV", "");
+
+  // Reflectors --
+
+  inline constexpr auto reflectorA = detail::parseCipher(
+    "EJMZALYXVBWFCRQUONTSPIKHGD");
+  inline constexpr auto reflectorB = detail::parseCipher(
+    "YRUHQSLDPXNGOKMIEBFZCWVJAT");
+  inline constexpr auto reflectorC = detail::parseCipher(
+    "FVPJIAOYEDRZXWGCTKUQSBNMHL");
+  inline constexpr auto reflectorBThin = detail::parseCipher(
+    "ENKQAUYWJICOPBLMDXZVFTHRGS");
+  inline constexpr auto reflectorCThin = detail::parseCipher(
+    "RDOBJNTKVEHMLFCWZAXGYIPSUQ");
+
+  static_assert(detail::isValid(rotorI));
+  static_assert(detail::isValid(rotorII));
+  static_assert(detail::isValid(rotorIII));
+  static_assert(detail::isValid(rotorIV));
+  static_assert(detail::isValid(rotorV));
+  static_assert(detail::isValid(rotorVI));
+  static_assert(detail::isValid(rotorVII));
+  static_assert(detail::isValid(rotorVIII));
+  static_assert(detail::isValid(rotorBeta));
+  static_assert(detail::isValid(rotorGamma));
+  static_assert(detail::isReflector(reflectorA));
+  static_assert(detail::isReflector(reflectorB));
+  static_assert(detail::isReflector(reflectorC));
+  static_assert(detail::isReflector(reflectorBThin));
+  static_assert(detail::isReflector(reflectorCThin));
+
+}
+
+#endif // ENIGMA_CATALOG_HPP
@@ -0,0 +1,221 @@
+#ifndef ENIGMA_CHAIN_HPP
+#define ENIGMA_CHAIN_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <array>
+
+#include "composite.hpp"
+#include "enigma.hpp"
+
+namespace enigma {
+
+  // MachineChain class --------------------------------------------------------
+  // Passes each value through `length` machines in turn, every machine
+  // advancing once per value, with the same output as calling `encodeNext`
+  // on each machine in sequence.
+  //
+  // As in `CompositeMachine`, each machine reduces to its first rotor around
+  // a cached inner composite. Every first rotor steps on every value, so the
+  // offsets between them never change. The exit through one machine's first
+  // rotor and the entry through the next are therefore fused into a single
+  // junction table, indexed by the position of the first machine's first
+  // rotor and built once. A value takes `2 * length + 1` lookups, against
+  // `3 * length` for separate composite machines.
+  //
+  // Carries are looked up in one table of machine masks per position, so a
+  // step which carries nowhere only touches a position counter. Only the
+  // machines which carry are stepped (see `CompositeMachine::knock`); the
+  // chain tracks their first rotors itself.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count,
+           std::size_t length>
+  class MachineChain {
+  public:
+
+    static_assert(length > 0u && length <= 64u);
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using MachineArray = std::array<MachineType, length>;
+    using Index = IndexT;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    static constexpr std::size_t getLength() {
+      return length;
+    }
+
+    MachineChain() = delete;
+
+    explicit MachineChain(MachineArray const & sources):
+        machines(makeComposites(sources,
+                                std::make_index_sequence<length>{})) {
+      position = sources[0].getPositions()[0];
+      for (auto k = 0u; k < length; ++k) {
+        auto first = sources[k].getPositions()[0];
+        offsets[k] = (first + base - position) % base;
+      }
+
+      // Entry, junction and exit tables, by the first machine's position.
+      entry.resize(base * base);
+      junctions.resize(length * base * base);
+      for (auto p = 0u; p < base; ++p) {
+        auto const row = p * base;
+        for (auto val = 0u; val < base; ++val) {
+          entry[row + val] = forwardAt(sources[0], p, val);
+          for (auto k = 0u; k < length; ++k) {
+            auto out = reverseAt(sources[k], p + offsets[k], val);
+            if (k + 1u < length) {
+              out = forwardAt(sources[k + 1u], p + offsets[k + 1u], out);
+            }
+            junctions[k * base * base + row + val] = out;
+          }
+        }
+      }
+
+      carries.fill(0u);
+      if (rotor_count > 1u) {
+        for (auto p = 0u; p < base; ++p) {
+          for (auto k = 0u; k < length; ++k) {
+            auto const & notches = sources[k].getRotors()[0].getNotches();
+            if (notches[(p + offsets[k]) % base]) {
+              carries[p] |= std::uint64_t{1u} << k;
+            }
+          }
+        }
+      }
+    }
+
+    // getMachines --
+    // Returns `EnigmaMachine`s in the same states as the chained machines.
+    //
+    [[nodiscard]] MachineArray getMachines() const {
+      return getMachines(std::make_index_sequence<length>{});
+    }
+
+    void advance(std::size_t steps = 1u) {
+      if (steps == 1u) {
+        step();
+        return;
+      }
+
+      for (auto k = 0u; k < length; ++k) {
+        machines[k].setPositions(getPositions(k));
+        machines[k].advance(steps);
+      }
+      position = (position + steps % base) % base;
+    }
+
+    [[nodiscard]] Index encode(Index val) const {
+      assert(val < base);
+      auto const row = position * base;
+      val = entry[row + val];
+      for (auto k = 0u; k < length; ++k) {
+        val = machines[k].getInnerComposite()[val];
+        val = junctions[k * base * base + row + val];
+      }
+      return val;
+    }
+
+    Index encodeNext(Index val) {
+      step();
+      return encode(val);
+    }
+
+    // encodeNext --
+    // Batch form of `encodeNext`.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = encodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+  private:
+
+    using CompositeType = CompositeMachine<IndexT, base, rotor_count>;
+
+    template<std::size_t ... I>
+    static std::array<CompositeType, length>
+    makeComposites(MachineArray const & machines, std::index_sequence<I...>) {
+      return {CompositeType{machines[I]}...};
+    }
+
+    template<std::size_t ... I>
+    MachineArray getMachines(std::index_sequence<I...>) const {
+      auto result = MachineArray{machines[I].getMachine()...};
+      for (auto k = 0u; k < length; ++k) {
+        result[k].setPositions(getPositions(k));
+      }
+      return result;
+    }
+
+    // getPositions --
+    // Positions of machine `k`. The first rotor of each composite machine is
+    // left behind, as the chain tracks it.
+    //
+    typename MachineType::PositionArray getPositions(std::size_t k) const {
+      auto positions = machines[k].getPositions();
+      positions[0] = (position + offsets[k]) % base;
+      return positions;
+    }
+
+    static Index forwardAt(MachineType const & machine, std::size_t position,
+                           std::size_t val) {
+      auto const & cipher = machine.getRotors()[0].getForwardCipher();
+      return cipher[(position + val) % base];
+    }
+
+    static Index reverseAt(MachineType const & machine, std::size_t position,
+                           std::size_t val) {
+      auto const & cipher = machine.getRotors()[0].getReverseCipher();
+      return cipher[(position + val) % base];
+    }
+
+    void step() {
+      if (++position == base) {
+        position = 0u;
+      }
+      auto const mask = carries[position];
+      if (mask == 0u) {
+        return;
+      }
+      for (auto k = 0u; k < length; ++k) {
+        if ((mask >> k) & 1u) {
+          machines[k].knock();
+        }
+      }
+    }
+
+    std::array<CompositeType, length> machines;
+    std::array<std::size_t, length> offsets;
+    std::size_t position;
+    std::vector<Index> entry;
+    std::vector<Index> junctions;
+    std::array<std::uint64_t, base> carries;
+  };
+
+  // MachineChain class deduction guides ---------------------------------------
+
+  template<class T, std::size_t length>
+  MachineChain(std::array<T, length> const &) ->
+    MachineChain<typename T::Index, T::getBase(), T::getRotorCount(), length>;
+
+}
+
+#endif // ENIGMA_CHAIN_HPP
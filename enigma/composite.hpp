@@ -0,0 +1,368 @@
+#ifndef ENIGMA_COMPOSITE_HPP
+#define ENIGMA_COMPOSITE_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <array>
+
+#include "enigma.hpp"
+
+namespace enigma {
+
+  // RebuildMode enumeration ---------------------------------------------------
+  // How `CompositeMachine` rebuilds composites when rotors beyond the first
+  // move.
+  //
+  // `immediate` - Rebuild on the step which moves the rotors. Cheapest on
+  //               average, but a step which carries through `n` rotors does
+  //               `n * base` work at once.
+  // `amortised` - Build the next composites in a spare set of tables, a share
+  //               at a time, over the steps leading up to the carry, then swap
+  //               them in. The worst case per step becomes roughly
+  //               `n * base / d` for a carry `d` steps away.
+  //
+  enum class RebuildMode {
+    immediate,
+    amortised
+  };
+
+  // CompositeMachine class ----------------------------------------------------
+  // Produces the same output as an `EnigmaMachine` while keeping a stack of
+  // cached composite tables, one per rotor level. The composite for level `k`
+  // maps a value entering rotor `k` to the value leaving it on the return
+  // pass, i.e. it folds rotors `k` to `rotor_count - 1`, the reflector and
+  // the reverse pass through the same rotors into one table.
+  //
+  // Encoding then only needs the first rotor and the level 1 composite (three
+  // lookups), whatever the number of rotors. When the machine steps, only the
+  // composites of the rotors which moved are rebuilt, from the highest moved
+  // level down to level 1. As rotor `k` moves roughly `base` times less often
+  // than rotor `k - 1`, the amortised rebuild cost per step stays close to
+  // constant for deep rotor stacks. See `RebuildMode` for bounding the cost
+  // of individual steps.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class CompositeMachine {
+  public:
+
+    static_assert(rotor_count > 0u);
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using Index = IndexT;
+    using CipherArray = std::array<Index, base>;
+    using PositionArray = typename MachineType::PositionArray;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    CompositeMachine() = delete;
+
+    // Constructor --
+    // Copies the wiring and current positions of `machine`.
+    //
+    explicit CompositeMachine(MachineType const & machine,
+                              RebuildMode mode = RebuildMode::immediate):
+        machine(machine),
+        positions(machine.getPositions()),
+        mode(mode) {
+
+      auto const & first = machine.getRotors()[0];
+      for (auto i = 0u; i < 2u * base; ++i) {
+        first_forward[i] = first.getForwardCipher()[i % base];
+        first_reverse[i] = first.getReverseCipher()[i % base];
+        wrap[i] = static_cast<Index>(i % base);
+      }
+      rebuild(rotor_count - 1u);
+    }
+
+    [[nodiscard]] RebuildMode getRebuildMode() const {
+      return mode;
+    }
+
+    // getMachine --
+    // Returns an `EnigmaMachine` in the same state as this machine.
+    //
+    [[nodiscard]] MachineType getMachine() const {
+      auto result = machine;
+      result.setPositions(positions);
+      return result;
+    }
+
+    [[nodiscard]] PositionArray const & getPositions() const {
+      return positions;
+    }
+
+    void setPositions(PositionArray const & positions) {
+      this->positions = positions;
+      rebuild(rotor_count - 1u);
+    }
+
+    // getInnerComposite --
+    // The level 1 composite (the reflector for a single rotor machine).
+    //
+    [[nodiscard]] CipherArray const & getInnerComposite() const {
+      return getLayer(1u);
+    }
+
+    // getInnerInverse --
+    // The inverse of the inner composite, as used by `decode`.
+    //
+    [[nodiscard]] CipherArray const & getInnerInverse() const {
+      return inner_inverse;
+    }
+
+    // advance --
+    // Advance by `steps`. Single steps honour the rebuild mode; seeks by more
+    // than one step always rebuild immediately.
+    //
+    void advance(std::size_t steps = 1u) {
+      if (steps == 1u && mode == RebuildMode::amortised) {
+        advanceAmortised();
+        return;
+      }
+
+      if (steps == 1u) {
+        auto level = carry(positions, 0u);
+        if (level > 0u) {
+          rebuild(level);
+        }
+        return;
+      }
+
+      // Seek arithmetically through the rotors then rebuild from the highest
+      // level which moved.
+      machine.setPositions(positions);
+      machine.advance(steps);
+      auto next = machine.getPositions();
+      auto level = rotor_count;
+      while (level-- > 1u && next[level] == positions[level]) {}
+      positions = next;
+      if (level > 0u) {
+        rebuild(level);
+      } else {
+        schedule();
+      }
+    }
+
+    // knock --
+    // Advance the rotors after the first by one step, as a turnover of the
+    // first rotor would, leaving the first rotor in place. For callers which
+    // track the first rotor themselves (see `MachineChain`).
+    //
+    void knock() {
+      if constexpr (rotor_count > 1u) {
+        rebuild(carry(positions, 1u));
+      }
+    }
+
+    [[nodiscard]] Index encode(Index val) const {
+      assert(val < base);
+      auto const & inner = getInnerComposite();
+      auto offset = positions[0];
+      return first_reverse[offset + inner[first_forward[offset + val]]];
+    }
+
+    Index encodeNext(Index val) {
+      advance();
+      return encode(val);
+    }
+
+    // decode --
+    // Inverse of `encode`, using the inverse of the inner composite which is
+    // maintained alongside it.
+    //
+    [[nodiscard]] Index decode(Index val) const {
+      assert(val < base);
+      auto offset = positions[0];
+      auto inner = wrap[first_forward[val] + base - offset];
+      return wrap[first_reverse[inner_inverse[inner]] + base - offset];
+    }
+
+    Index decodeNext(Index val) {
+      advance();
+      return decode(val);
+    }
+
+    // encodeNext --
+    // Batch form of `encodeNext`. Encodes the values in `[first, last)` to
+    // `out`, advancing before each one.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = encodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+    // decodeNext --
+    // Batch form of `decodeNext`.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt decodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = decodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+  private:
+
+    [[nodiscard]] CipherArray const & getLayer(std::size_t level) const {
+      return (level < rotor_count) ? layers[level] : machine.getReflector();
+    }
+
+    // carry --
+    // Advance rotor `level` of `state` by one step, carrying into following
+    // rotors as `Rotor::advance` does. Returns the highest level which moved.
+    //
+    std::size_t carry(PositionArray & state, std::size_t level) const {
+      auto const & rotors = machine.getRotors();
+      while (true) {
+        if (++state[level] == base) {
+          state[level] = 0u;
+        }
+        if (level + 1u == rotor_count ||
+            !rotors[level].getNotches()[state[level]]) {
+          return level;
+        }
+        ++level;
+      }
+    }
+
+    // buildEntry --
+    // Compute entry `val` of the composite for `level` at rotor positions
+    // `state`, given the composite of the level above.
+    //
+    Index buildEntry(CipherArray const & next, PositionArray const & state,
+                     std::size_t level, std::size_t val) const {
+      auto const & rotor = machine.getRotors()[level];
+      auto offset = state[level];
+      auto inner = next[rotor.getForwardCipher()[(offset + val) % base]];
+      return rotor.getReverseCipher()[(offset + inner) % base];
+    }
+
+    // rebuild --
+    // Recompute the composites for levels `top` down to 1, and the inverse
+    // of the inner composite.
+    //
+    void rebuild(std::size_t top) {
+      for (auto level = top; level > 0u; --level) {
+        auto const & next = getLayer(level + 1u);
+        for (auto val = 0u; val < base; ++val) {
+          layers[level][val] = buildEntry(next, positions, level, val);
+        }
+      }
+
+      auto const & inner = getInnerComposite();
+      for (auto val = 0u; val < base; ++val) {
+        inner_inverse[inner[val]] = static_cast<Index>(val);
+      }
+      schedule();
+    }
+
+    // Amortised rebuilds --
+    // `schedule` predicts the next carry out of the first rotor and the
+    // positions it leads to. Each following step builds a share of the
+    // composites for those positions into `pending`, top level first and the
+    // inverse of the inner composite last, so that all are complete on the
+    // step of the carry, where they are swapped in.
+
+    void schedule() {
+      pending_steps = 0u;
+      if (mode != RebuildMode::amortised || rotor_count == 1u) {
+        return;
+      }
+
+      auto const & notches = machine.getRotors()[0].getNotches();
+      if (notches.none()) {
+        return;
+      }
+
+      auto distance = std::size_t{1u};
+      while (!notches[(positions[0] + distance) % base]) {
+        ++distance;
+      }
+
+      pending_positions = positions;
+      pending_positions[0] = (positions[0] + distance) % base;
+      pending_top = carry(pending_positions, 1u);
+      pending_steps = distance;
+      pending_done = 0u;
+    }
+
+    [[nodiscard]] std::size_t getPendingTotal() const {
+      return (pending_top + 1u) * base;
+    }
+
+    void buildPending(std::size_t count) {
+      auto end = std::min(pending_done + count, getPendingTotal());
+      for (; pending_done < end; ++pending_done) {
+        auto val = pending_done % base;
+        if (pending_done >= pending_top * base) {
+          pending_inverse[pending[1][val]] = static_cast<Index>(val);
+          continue;
+        }
+
+        auto level = pending_top - pending_done / base;
+        auto const & next = (level < pending_top) ?
+          pending[level + 1u] : getLayer(level + 1u);
+        pending[level][val] =
+          buildEntry(next, pending_positions, level, val);
+      }
+    }
+
+    void advanceAmortised() {
+      if (pending_steps > 0u) {
+        auto remaining = getPendingTotal() - pending_done;
+        buildPending((remaining + pending_steps - 1u) / pending_steps);
+        --pending_steps;
+      }
+
+      auto level = carry(positions, 0u);
+      if (level == 0u) {
+        return;
+      }
+
+      assert(positions == pending_positions && level == pending_top);
+      for (auto i = 1u; i <= level; ++i) {
+        std::swap(layers[i], pending[i]);
+      }
+      std::swap(inner_inverse, pending_inverse);
+      schedule();
+    }
+
+    MachineType machine;
+    PositionArray positions;
+    RebuildMode mode;
+    PositionArray pending_positions = {};
+    std::size_t pending_top = 0u;
+    std::size_t pending_steps = 0u;
+    std::size_t pending_done = 0u;
+    std::array<CipherArray, rotor_count> pending;
+    CipherArray pending_inverse;
+    std::array<Index, 2u * base> first_forward;
+    std::array<Index, 2u * base> first_reverse;
+    std::array<Index, 2u * base> wrap;
+    std::array<CipherArray, rotor_count> layers;
+    CipherArray inner_inverse;
+  };
+
+  // CompositeMachine class deduction guides -----------------------------------
+
+  template<class T> CompositeMachine(T const &) ->
+    CompositeMachine<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_COMPOSITE_HPP
@@ -0,0 +1,220 @@
+#ifndef ENIGMA_DATAGRAM_HPP
+#define ENIGMA_DATAGRAM_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <algorithm>
+#include <iterator>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <array>
+
+#include "enigma.hpp"
+
+namespace enigma {
+
+  // DatagramDecoder class -----------------------------------------------------
+  // Decodes datagrams cut from one enciphered stream, which may arrive out of
+  // order or not at all. Each datagram carries the stream offset of its first
+  // symbol; symbol `i` of the stream was enciphered by `encodeNext` after `i`
+  // earlier symbols, starting from the machine's positions when the decoder
+  // is made. Output is identical to `EnigmaMachine::decodeNext` replayed
+  // from the start of the stream.
+  //
+  // The decoder keeps a cursor: the rotor positions at the end of the last
+  // datagram. A datagram which starts at the cursor continues from it with
+  // no seek. Any other is reached arithmetically, counting the notches each
+  // rotor passes (as `Rotor::countKnocks`), forward from the cursor or from
+  // the start of the stream, in `O(rotor_count)` whatever the distance.
+  // `decodeBatch` decodes a batch in offset order, so that neighbouring
+  // datagrams continue from one another.
+  //
+  // Symbols are code points (`Index`). A decoder holds one stream and may be
+  // used by one thread at a time.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class DatagramDecoder {
+  public:
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using PositionArray = typename MachineType::PositionArray;
+    using Index = IndexT;
+
+    // Datagram struct --
+    // `size` symbols at `data`, the first at stream offset `offset`, decoded
+    // into `out`.
+    //
+    struct Datagram {
+      std::uint64_t offset;
+      Index const * data;
+      std::size_t size;
+      Index * out;
+    };
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    DatagramDecoder() = delete;
+
+    explicit DatagramDecoder(MachineType const & machine):
+        start(machine.getPositions()),
+        positions(start) {
+      auto const & rotors = machine.getRotors();
+      for (auto r = 0u; r < rotor_count; ++r) {
+        auto & table = tables[r];
+        for (auto i = 0u; i < 2u * base; ++i) {
+          table.forward[i] = rotors[r].getForwardCipher()[i % base];
+          table.reverse[i] = rotors[r].getReverseCipher()[i % base];
+        }
+        fillKnocks(table.knocks, rotors[r].getNotches(), base);
+      }
+      auto const & reflector = machine.getReflector();
+      for (auto i = 0u; i < base; ++i) {
+        reflector_inverse[reflector[i]] = static_cast<Index>(i);
+        reflector_inverse[reflector[i] + base] = static_cast<Index>(i);
+      }
+    }
+
+    // decode --
+    // Decodes the symbols `[first, last)` starting at stream `offset` into
+    // `out`.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt decode(std::uint64_t offset, InputIt first, InputIt last,
+                    OutputIt out) {
+      moveTo(offset);
+      for (; first != last; ++first, ++out, ++cursor) {
+        step();
+        *out = decodeSymbol(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+    // decodeBatch --
+    // Decodes each of the datagrams `[first, last)`, in offset order.
+    //
+    template<class DatagramIt>
+    void decodeBatch(DatagramIt first, DatagramIt last) {
+      auto count = static_cast<std::size_t>(std::distance(first, last));
+      order.resize(count);
+      for (auto i = 0u; i < count; ++i) {
+        order[i] = &first[static_cast<std::ptrdiff_t>(i)];
+      }
+      auto by_offset = [](Datagram const * lhs, Datagram const * rhs) {
+        return lhs->offset < rhs->offset;
+      };
+      if (!std::is_sorted(order.begin(), order.end(), by_offset)) {
+        std::sort(order.begin(), order.end(), by_offset);
+      }
+      for (auto const * datagram : order) {
+        decode(datagram->offset, datagram->data,
+               datagram->data + datagram->size, datagram->out);
+      }
+    }
+
+    // getSeekCount --
+    // Number of datagrams which did not start at the cursor.
+    //
+    [[nodiscard]] std::size_t getSeekCount() const {
+      return seeks;
+    }
+
+  private:
+
+    // Tables struct --
+    // Ciphers doubled, so that an offset code point needs no modulo, and
+    // prefix sums of the notches over two turns (see `EncodedView`).
+    //
+    struct Tables {
+      std::array<Index, 2u * base> forward;
+      std::array<Index, 2u * base> reverse;
+      std::array<std::size_t, 2u * base + 1u> knocks;
+    };
+
+    // moveTo --
+    // Sets the positions to those after `offset` symbols.
+    //
+    void moveTo(std::uint64_t offset) {
+      if (offset == cursor) {
+        return;
+      }
+      ++seeks;
+      if (offset < cursor) {
+        positions = start;
+        seek(offset);
+      } else {
+        seek(offset - cursor);
+      }
+      cursor = offset;
+    }
+
+    // seek --
+    // Advances the positions by `steps`, carrying as `EnigmaMachine::advance`.
+    //
+    void seek(std::uint64_t steps) {
+      for (auto r = 0u; r < rotor_count && steps > 0u; ++r) {
+        auto position = positions[r];
+        positions[r] = static_cast<std::size_t>(
+          (position + steps % base) % base);
+        steps = countKnocks(tables[r].knocks, base, position, steps);
+      }
+    }
+
+    void step() {
+      for (auto r = 0u; r < rotor_count; ++r) {
+        if (++positions[r] == base) {
+          positions[r] = 0u;
+        }
+        if (!hasNotch(tables[r].knocks, positions[r])) {
+          break;
+        }
+      }
+    }
+
+    // decodeSymbol --
+    // As `EnigmaMachine::decode` at the current positions. Each stage of
+    // `decode` subtracts a rotor position after its lookup; the subtraction
+    // is deferred into the index of the next lookup, whose table is doubled,
+    // so that only the last needs reducing.
+    //
+    [[nodiscard]] Index decodeSymbol(Index val) const {
+      assert(val < base);
+      auto index = std::size_t{tables[0].forward[val]};
+      for (auto r = 1u; r < rotor_count; ++r) {
+        index = tables[r].forward[index + base - positions[r - 1u]];
+      }
+      index = reflector_inverse[index + base - positions[rotor_count - 1u]];
+      index = tables[rotor_count - 1u].reverse[index];
+      for (auto r = rotor_count - 1u; r-- > 0u;) {
+        index = tables[r].reverse[index + base - positions[r + 1u]];
+      }
+      index += base - positions[0];
+      return static_cast<Index>(index < base ? index : index - base);
+    }
+
+    std::array<Tables, rotor_count> tables = {};
+    std::array<Index, 2u * base> reflector_inverse = {};
+    PositionArray start;
+    PositionArray positions;
+    std::uint64_t cursor = 0u;
+    std::size_t seeks = 0u;
+    std::vector<Datagram const *> order;
+  };
+
+  // DatagramDecoder class deduction guides ------------------------------------
+
+  template<class T> DatagramDecoder(T const &) ->
+    DatagramDecoder<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_DATAGRAM_HPP
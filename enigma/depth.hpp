@@ -0,0 +1,309 @@
+#ifndef ENIGMA_DEPTH_HPP
+#define ENIGMA_DEPTH_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <tuple>
+#include <cmath>
+#include <mutex>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ENIGMA_DEPTH_AVX2 1
+#endif
+
+namespace enigma {
+
+  // DepthOptions struct -------------------------------------------------------
+  // `kappa` - Rate at which two plaintexts agree symbol for symbol. Two
+  //           messages in depth show it in their ciphertexts; messages not
+  //           in depth agree at `1 / base`.
+  // `max_offset` - Largest shift between two messages which is tried.
+  // `min_overlap` - Shortest overlap which is scored.
+  // `threshold` - Least score, in decibans, reported as a depth.
+  // `threads` - Threads used to search; 0 for one per hardware thread.
+  //
+  struct DepthOptions {
+    double kappa = 0.0667;
+    std::size_t max_offset = 25u;
+    std::size_t min_overlap = 20u;
+    double threshold = 20.0;
+    unsigned threads = 0u;
+  };
+
+  // Depth struct --------------------------------------------------------------
+  // Two messages which appear to be in depth: symbol `i` of message `second`
+  // was enciphered at the same machine position as symbol `i + offset` of
+  // message `first`.
+  //
+  struct Depth {
+    std::size_t first;
+    std::size_t second;
+    std::ptrdiff_t offset;
+    std::size_t overlap;
+    std::size_t coincidences;
+    double score;
+  };
+
+  // DepthSearch class ---------------------------------------------------------
+  // Finds messages enciphered at overlapping machine positions, as in
+  // Banburismus. Every pair of messages is compared at every offset up to
+  // `max_offset`, counting the symbols which coincide in their overlap.
+  //
+  // Each coincidence and each disagreement is weighed as evidence for depth
+  // against the chance rate, and the weights summed (a sequential
+  // probability ratio test). Weights are in decibans: a coincidence adds
+  // `10 log10(kappa * base)` and a disagreement
+  // `10 log10((1 - kappa) / (1 - 1 / base))`.
+  //
+  // Messages are held in one contiguous buffer of symbols, so that a large
+  // set (10^5 messages and more) costs one allocation. Coincidences are
+  // counted 32 symbols at a time with AVX2 byte compares and a popcount of
+  // the mask, where the CPU supports it. Pairs are numbered row by row and
+  // taken by threads in blocks of `pair_block` from a shared counter, so
+  // threads stay balanced although earlier messages have more pairs.
+  //
+  template<class IndexT, std::size_t base>
+  class DepthSearch {
+  public:
+
+    static_assert(base > 1u && base <= 256u);
+
+    using Index = IndexT;
+
+    static constexpr std::size_t pair_block = 64u;
+
+    explicit DepthSearch(DepthOptions const & options = {}):
+        options(options) {
+      hit_weight = 10.0 * std::log10(options.kappa * base);
+      miss_weight = 10.0 * std::log10((1.0 - options.kappa) /
+                                      (1.0 - 1.0 / base));
+      if (this->options.threads == 0u) {
+        this->options.threads =
+          std::max(1u, std::thread::hardware_concurrency());
+      }
+      starts.push_back(0u);
+    }
+
+    // add --
+    // Adds the message `[first, last)` and returns its number.
+    //
+    template<class InputIt>
+    std::size_t add(InputIt first, InputIt last) {
+      // The new message overwrites the padding after the last.
+      symbols.resize(starts.back());
+      for (; first != last; ++first) {
+        assert(static_cast<std::size_t>(*first) < base);
+        symbols.push_back(static_cast<std::uint8_t>(*first));
+      }
+      starts.push_back(symbols.size());
+      symbols.resize(symbols.size() + padding);
+      return starts.size() - 2u;
+    }
+
+    std::size_t add(std::vector<Index> const & message) {
+      return add(message.begin(), message.end());
+    }
+
+    [[nodiscard]] std::size_t getMessageCount() const {
+      return starts.size() - 1u;
+    }
+
+    // getPairCount --
+    // Number of pairs compared by `search(first, last)`.
+    //
+    [[nodiscard]] std::size_t getPairCount(std::size_t first,
+                                           std::size_t last) const {
+      auto count = std::size_t{0u};
+      for (auto i = first; i < last; ++i) {
+        count += getMessageCount() - i - 1u;
+      }
+      return count;
+    }
+
+    // getScore --
+    // Decibans in favour of depth for `coincidences` in `overlap` symbols.
+    //
+    [[nodiscard]] double getScore(std::size_t overlap,
+                                  std::size_t coincidences) const {
+      return coincidences * hit_weight + (overlap - coincidences) * miss_weight;
+    }
+
+    // search --
+    // Returns every depth between message `i` and a later message, for `i`
+    // in `[first, last)`, scoring at least `threshold`. Each pair reports
+    // its best offset only. Depths are in descending order of score.
+    //
+    [[nodiscard]] std::vector<Depth> search(std::size_t first,
+                                            std::size_t last) const {
+      assert(first <= last && last <= getMessageCount());
+
+      // `row_ends[r]` is the number of pairs up to the end of row `first + r`.
+      auto const count = getMessageCount();
+      auto row_ends = std::vector<std::size_t>{};
+      auto total = std::size_t{0u};
+      for (auto i = first; i < last; ++i) {
+        total += count - i - 1u;
+        row_ends.push_back(total);
+      }
+
+      auto results = std::vector<Depth>{};
+      auto mutex = std::mutex{};
+      auto next = std::atomic<std::size_t>{0u};
+
+      auto worker = [&] {
+        auto found = std::vector<Depth>{};
+        for (auto begin = next.fetch_add(pair_block); begin < total;
+             begin = next.fetch_add(pair_block)) {
+          auto end = std::min(begin + pair_block, total);
+          auto row = static_cast<std::size_t>(
+            std::upper_bound(row_ends.begin(), row_ends.end(), begin) -
+            row_ends.begin());
+          auto i = first + row;
+          auto j = count - (row_ends[row] - begin);
+          for (auto k = begin; k < end; ++k) {
+            auto depth = comparePair(i, j);
+            if (depth.score >= options.threshold) {
+              found.push_back(depth);
+            }
+            if (++j == count) {
+              ++i;
+              j = i + 1u;
+            }
+          }
+        }
+        auto lock = std::lock_guard{mutex};
+        results.insert(results.end(), found.begin(), found.end());
+      };
+
+      auto pool = std::vector<std::thread>{};
+      for (auto i = 1u; i < options.threads; ++i) {
+        pool.emplace_back(worker);
+      }
+      worker();
+      for (auto & thread : pool) {
+        thread.join();
+      }
+
+      std::sort(results.begin(), results.end(),
+                [](Depth const & lhs, Depth const & rhs) {
+                  if (lhs.score != rhs.score) {
+                    return lhs.score > rhs.score;
+                  }
+                  return std::tie(lhs.first, lhs.second) <
+                         std::tie(rhs.first, rhs.second);
+                });
+      return results;
+    }
+
+    [[nodiscard]] std::vector<Depth> search() const {
+      return search(0u, getMessageCount());
+    }
+
+    // comparePair --
+    // Scores messages `first` and `second` at every offset and returns the
+    // best. The score is negative infinity if no overlap is long enough.
+    //
+    [[nodiscard]] Depth comparePair(std::size_t first,
+                                    std::size_t second) const {
+      auto const * a = symbols.data() + starts[first];
+      auto const * b = symbols.data() + starts[second];
+      auto const a_size = starts[first + 1u] - starts[first];
+      auto const b_size = starts[second + 1u] - starts[second];
+
+      auto best = Depth{first, second, 0, 0u, 0u,
+                         -std::numeric_limits<double>::infinity()};
+      auto const span = static_cast<std::ptrdiff_t>(options.max_offset);
+      for (auto offset = -span; offset <= span; ++offset) {
+        auto a_skip = static_cast<std::size_t>(offset > 0 ? offset : 0);
+        auto b_skip = static_cast<std::size_t>(offset < 0 ? -offset : 0);
+        if (a_skip >= a_size || b_skip >= b_size) {
+          continue;
+        }
+        auto overlap = std::min(a_size - a_skip, b_size - b_skip);
+        if (overlap < options.min_overlap) {
+          continue;
+        }
+
+        auto coincidences = countCoincidences(a + a_skip, b + b_skip,
+                                              overlap);
+        auto score = getScore(overlap, coincidences);
+        if (score > best.score) {
+          best = Depth{first, second, offset, overlap, coincidences, score};
+        }
+      }
+      return best;
+    }
+
+  private:
+
+    // Bytes after the last message which may be read, but are never counted.
+    // Messages are packed without gaps, so a read past the end of any other
+    // message runs into the next instead.
+    static constexpr std::size_t padding = 32u;
+
+    // countCoincidences --
+    // Number of positions `i < size` at which `a[i] == b[i]`. Reads up to
+    // `padding` bytes past the end of either range.
+    //
+    static std::size_t countCoincidences(std::uint8_t const * a,
+                                         std::uint8_t const * b,
+                                         std::size_t size) {
+      auto count = std::size_t{0u};
+      auto i = std::size_t{0u};
+#if defined(ENIGMA_DEPTH_AVX2)
+      if (has_avx2) {
+        i = countCoincidencesAvx2(a, b, size, count);
+      }
+#endif
+      for (; i < size; ++i) {
+        count += (a[i] == b[i]);
+      }
+      return count;
+    }
+
+#if defined(ENIGMA_DEPTH_AVX2)
+    static inline bool const has_avx2 = __builtin_cpu_supports("avx2");
+
+    // countCoincidencesAvx2 --
+    // As `countCoincidences`, 32 symbols at a time, the last block masked to
+    // `size`. Adds to `count` and returns the number of symbols done.
+    //
+    __attribute__((target("avx2,popcnt"))) static std::size_t
+    countCoincidencesAvx2(std::uint8_t const * a, std::uint8_t const * b,
+                          std::size_t size, std::size_t & count) {
+      auto i = std::size_t{0u};
+      for (; i < size; i += 32u) {
+        auto lhs = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+        auto rhs = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + i));
+        auto mask = static_cast<std::uint32_t>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)));
+        if (size - i < 32u) {
+          mask &= (std::uint32_t{1u} << (size - i)) - 1u;
+        }
+        count += static_cast<std::size_t>(__builtin_popcount(mask));
+      }
+      return size;
+    }
+#endif
+
+    DepthOptions options;
+    double hit_weight;
+    double miss_weight;
+    std::vector<std::uint8_t> symbols;
+    std::vector<std::size_t> starts;
+  };
+
+}
+
+#endif // ENIGMA_DEPTH_HPP
@@ -0,0 +1,112 @@
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <type_traits>
+#include <cstdint>
+#include <cstdio>
+#include <array>
+
+#include "embedded.hpp"
+#include "catalog.hpp"
+
+// Embedded stream cipher ------------------------------------------------------
+// Enciphers standard input to standard output with the machine of
+// `enigma stream`, built with the embedded profile. The target is compiled
+// with `-fno-exceptions -fno-rtti` and uses no heap, so its size and startup
+// cost approximate firmware. Output is identical to `enigma stream`: the
+// machine advances once per byte and only letters are substituted.
+//
+// Usage: enigma_embedded
+
+namespace {
+
+  using namespace enigma;
+
+  using catalog::Index;
+  using catalog::base;
+
+  constexpr auto makeRotorTables(catalog::RotorWiring const & wiring) {
+    return embedded::makeRotorTables<Index, base>(wiring.forward,
+                                                  wiring.notches);
+  }
+
+  // Rotors III, II and I (III fastest) with reflector B, as `enigma stream`.
+  constexpr auto wiring = embedded::makeWiring(
+    std::array{
+      makeRotorTables(catalog::rotorIII),
+      makeRotorTables(catalog::rotorII),
+      makeRotorTables(catalog::rotorI)
+    },
+    catalog::reflectorB);
+
+  using MachineType = embedded::Machine<wiring>;
+
+  // The state is the rotor positions alone, and owns nothing.
+  static_assert(sizeof(MachineType) == 3u * sizeof(Index));
+  static_assert(std::is_trivially_copyable_v<MachineType>);
+  static_assert(std::is_trivially_destructible_v<MachineType>);
+
+  // Checked at compile time against `enigma stream`, which enciphers "AAAAA"
+  // to "ULADC". Decoding reverses it, and seeking matches stepping.
+  constexpr bool checkMachine() {
+    auto machine = MachineType{};
+    auto const expected = std::array<Index, 5u>{20u, 11u, 0u, 3u, 2u};
+    for (auto val : expected) {
+      if (machine.encodeNext(0u) != val) {
+        return false;
+      }
+    }
+    machine = MachineType{};
+    for (auto val : expected) {
+      if (machine.decodeNext(val) != 0u) {
+        return false;
+      }
+    }
+    machine = MachineType{};
+    machine.advance(16905u);
+    auto stepped = MachineType{};
+    for (auto i = 0u; i < 16905u; ++i) {
+      stepped.advance();
+    }
+    auto const seeked = machine.getPositions();
+    auto const positions = stepped.getPositions();
+    for (auto r = 0u; r < positions.size(); ++r) {
+      if (seeked[r] != positions[r]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static_assert(checkMachine());
+
+  void encode(unsigned char * bytes, std::size_t size,
+              MachineType & machine) {
+    for (auto i = std::size_t{0u}; i < size; ++i) {
+      auto c = bytes[i];
+      machine.advance();
+      if (c >= 'A' && c <= 'Z') {
+        bytes[i] = static_cast<unsigned char>('A' + machine.encode(c - 'A'));
+      } else if (c >= 'a' && c <= 'z') {
+        bytes[i] = static_cast<unsigned char>('a' + machine.encode(c - 'a'));
+      }
+    }
+  }
+
+}
+
+// -----------------------------------------------------------------------------
+
+int main() {
+  static unsigned char buffer[4096];
+  auto machine = MachineType{};
+  auto size = std::size_t{0u};
+  while ((size = std::fread(buffer, 1u, sizeof(buffer), stdin)) > 0u) {
+    encode(buffer, size, machine);
+    if (std::fwrite(buffer, 1u, size, stdout) != size) {
+      return 1;
+    }
+  }
+  return std::ferror(stdin) ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+#ifndef ENIGMA_EMBEDDED_HPP
+#define ENIGMA_EMBEDDED_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <type_traits>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <array>
+
+#include "enigma.hpp"
+
+namespace enigma::embedded {
+
+  // Embedded profile ----------------------------------------------------------
+  // A footprint-oriented counterpart to `Rotor` and `EnigmaMachine` for small
+  // targets. Wiring is a literal type built by constexpr functions, so a
+  // `constexpr` wiring object is placed in read-only storage and nothing is
+  // computed at startup. A `Machine` refers to its wiring through a template
+  // parameter and holds only the rotor positions, one `Index` per rotor.
+  // Nothing allocates, throws, or uses RTTI or `std::function`, so the
+  // profile builds with `-fno-exceptions -fno-rtti`.
+  //
+  // Stepping and ciphers are identical to `EnigmaMachine`.
+  //
+
+  // RotorTables struct --------------------------------------------------------
+  // Forward and reverse ciphers, doubled so that an offset code point needs
+  // no modulo, and prefix sums of the notches over two turns, such that
+  // `knocks[i]` is the number of notches at positions `[0, i)` of the doubled
+  // rotor.
+  //
+  template<class IndexT, std::size_t base>
+  struct RotorTables {
+
+    static_assert(std::numeric_limits<IndexT>::max() >= base);
+    static_assert(std::is_unsigned_v<IndexT>);
+    static_assert(base > 0u);
+
+    using Index = IndexT;
+    using Count = std::conditional_t<
+      (2u * base <= std::numeric_limits<std::uint16_t>::max()),
+      std::uint16_t, std::size_t>;
+
+    std::array<Index, 2u * base> forward;
+    std::array<Index, 2u * base> reverse;
+    std::array<Count, 2u * base + 1u> knocks;
+  };
+
+  // Wiring struct -------------------------------------------------------------
+
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  struct Wiring {
+
+    static_assert(rotor_count > 0u);
+
+    using Index = IndexT;
+    using RotorType = RotorTables<Index, base>;
+    using ReflectorType = std::array<Index, base>;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    std::array<RotorType, rotor_count> rotors;
+    ReflectorType reflector;
+    ReflectorType reflector_inverse;
+  };
+
+  // makeRotorTables --
+  // `cipher` - Forward cipher, indexable by code point (e.g. `std::array`).
+  // `notches` - Indexable by code point, true where a notch exists (e.g.
+  //             `std::array<bool, base>` or `std::bitset<base>`).
+  //
+  template<class IndexT, std::size_t base, class CipherT, class NotchesT>
+  constexpr RotorTables<IndexT, base>
+  makeRotorTables(CipherT const & cipher, NotchesT const & notches) {
+    auto tables = RotorTables<IndexT, base>{};
+    for (auto i = std::size_t{0u}; i < base; ++i) {
+      assert(cipher[i] < base);
+      tables.forward[i] = static_cast<IndexT>(cipher[i]);
+      tables.forward[i + base] = static_cast<IndexT>(cipher[i]);
+      tables.reverse[cipher[i]] = static_cast<IndexT>(i);
+      tables.reverse[cipher[i] + base] = static_cast<IndexT>(i);
+    }
+    fillKnocks(tables.knocks, notches, base);
+    return tables;
+  }
+
+  // makeWiring --
+  // `rotors` - Array of `RotorTables`, in the order a symbol passes through.
+  // `reflector` - Reflector cipher, indexable by code point.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count,
+           class ReflectorT>
+  constexpr Wiring<IndexT, base, rotor_count>
+  makeWiring(std::array<RotorTables<IndexT, base>, rotor_count> const & rotors,
+             ReflectorT const & reflector) {
+    auto wiring = Wiring<IndexT, base, rotor_count>{};
+    wiring.rotors = rotors;
+    for (auto i = std::size_t{0u}; i < base; ++i) {
+      wiring.reflector[i] = static_cast<IndexT>(reflector[i]);
+      wiring.reflector_inverse[reflector[i]] = static_cast<IndexT>(i);
+    }
+    return wiring;
+  }
+
+  // makeWiring --
+  // Copies the wiring of an `EnigmaMachine`, or any machine with the same
+  // `getRotors` and `getReflector` interface.
+  //
+  template<class MachineT>
+  Wiring<typename MachineT::Index, MachineT::getBase(),
+         MachineT::getRotorCount()>
+  makeWiring(MachineT const & machine) {
+    using Index = typename MachineT::Index;
+    constexpr auto base = MachineT::getBase();
+    auto rotors = std::array<RotorTables<Index, base>,
+                             MachineT::getRotorCount()>{};
+    for (auto r = std::size_t{0u}; r < rotors.size(); ++r) {
+      auto const & rotor = machine.getRotors()[r];
+      rotors[r] = makeRotorTables<Index, base>(rotor.getForwardCipher(),
+                                               rotor.getNotches());
+    }
+    return makeWiring(rotors, machine.getReflector());
+  }
+
+  // Machine class -------------------------------------------------------------
+  // `wiring` - A `Wiring` object with static storage duration, normally
+  //            `constexpr`. Its tables are read in place; the machine stores
+  //            no pointer to them.
+  //
+  template<auto const & wiring>
+  class Machine {
+  public:
+
+    using WiringType = std::remove_cv_t<
+      std::remove_reference_t<decltype(wiring)>>;
+    using Index = typename WiringType::Index;
+    using PositionArray = std::array<std::size_t,
+                                     WiringType::getRotorCount()>;
+
+    static constexpr std::size_t getBase() {
+      return WiringType::getBase();
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return WiringType::getRotorCount();
+    }
+
+    constexpr Machine() = default;
+
+    constexpr explicit Machine(PositionArray const & positions) {
+      setPositions(positions);
+    }
+
+    [[nodiscard]] constexpr PositionArray getPositions() const {
+      auto result = PositionArray{};
+      for (auto r = std::size_t{0u}; r < getRotorCount(); ++r) {
+        result[r] = positions[r];
+      }
+      return result;
+    }
+
+    // setPositions --
+    // Set the position of every rotor directly, without turnovers.
+    //
+    constexpr void setPositions(PositionArray const & values) {
+      for (auto r = std::size_t{0u}; r < getRotorCount(); ++r) {
+        assert(values[r] < getBase());
+        positions[r] = static_cast<Index>(values[r]);
+      }
+    }
+
+    // advance --
+    // Advance by one step. A notch at a rotor's new position carries into
+    // the next rotor.
+    //
+    constexpr void advance() {
+      for (auto r = std::size_t{0u}; r < getRotorCount(); ++r) {
+        auto position = positions[r] + 1u;
+        if (position == getBase()) {
+          position = 0u;
+        }
+        positions[r] = static_cast<Index>(position);
+        if (!hasNotch(wiring.rotors[r].knocks, position)) {
+          break;
+        }
+      }
+    }
+
+    // advance --
+    // Advance by `steps`, counting the notches each rotor passes rather than
+    // stepping, as `EnigmaMachine::advance`.
+    //
+    constexpr void advance(std::size_t steps) {
+      constexpr auto base = getBase();
+      for (auto r = std::size_t{0u}; r < getRotorCount() && steps > 0u; ++r) {
+        auto const position = std::size_t{positions[r]};
+        positions[r] = static_cast<Index>((position + steps % base) % base);
+        steps = countKnocks(wiring.rotors[r].knocks, base, position, steps);
+      }
+    }
+
+    [[nodiscard]] constexpr Index encode(Index val) const {
+      assert(val < getBase());
+      for (auto r = std::size_t{0u}; r < getRotorCount(); ++r) {
+        val = wiring.rotors[r].forward[positions[r] + val];
+      }
+      val = wiring.reflector[val];
+      for (auto r = getRotorCount(); r-- > 0u;) {
+        val = wiring.rotors[r].reverse[positions[r] + val];
+      }
+      return val;
+    }
+
+    constexpr Index encodeNext(Index val) {
+      advance();
+      return encode(val);
+    }
+
+    // decode --
+    // Inverse of `encode` at the current position, as
+    // `EnigmaMachine::decode`.
+    //
+    [[nodiscard]] constexpr Index decode(Index val) const {
+      assert(val < getBase());
+      for (auto r = std::size_t{0u}; r < getRotorCount(); ++r) {
+        val = unoffset(wiring.rotors[r].forward[val], positions[r]);
+      }
+      val = wiring.reflector_inverse[val];
+      for (auto r = getRotorCount(); r-- > 0u;) {
+        val = unoffset(wiring.rotors[r].reverse[val], positions[r]);
+      }
+      return val;
+    }
+
+    constexpr Index decodeNext(Index val) {
+      advance();
+      return decode(val);
+    }
+
+    // encodeNext --
+    // Enciphers `[first, last)` into `out`, advancing before each symbol.
+    //
+    template<class InputIt, class OutputIt>
+    constexpr OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = encodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+  private:
+
+    static constexpr Index unoffset(Index val, Index position) {
+      auto result = std::size_t{val} + getBase() - position;
+      return static_cast<Index>(result < getBase() ? result :
+                                                      result - getBase());
+    }
+
+    std::array<Index, WiringType::getRotorCount()> positions = {};
+  };
+
+}
+
+#endif // ENIGMA_EMBEDDED_HPP
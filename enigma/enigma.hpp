@@ -5,9 +5,12 @@
 #error Minimum language standard requirement not met (C++17).
 #endif
 
+#include <type_traits>
 #include <functional>
 #include <cassert>
+#include <limits>
 #include <bitset>
+#include <array>
 
 #include "util.hpp"
 
@@ -75,6 +78,18 @@ namespace enigma {
       }
     }
 
+    // Constructor --
+    // As above, with `reverse` given as the inverse of `cipher` rather than
+    // computed, for precomputed tables (see `catalog.hpp`).
+    //
+    Rotor(CipherArray const & cipher, CipherArray const & reverse,
+          NotchArray const & notches, TurnoverFunc callback = ignoreTurnover):
+        turnover_callback(std::move(callback)),
+        forward_cipher(cipher),
+        reverse_cipher(reverse),
+        position(0u),
+        notches(notches) {}
+
     [[nodiscard]] TurnoverFunc getTurnoverCallback() const {
       return turnover_callback;
     }
@@ -107,16 +122,8 @@ namespace enigma {
     // invoke the turnover callback with the number of notches encountered.
     //
     std::size_t advance(std::size_t steps) {
-      auto next = position + steps;
-      auto knocks = (next / base) * notches.count();
-      next = next % base;
-
-      auto mask = ~NotchArray{};
-      auto[lead, trail] = util::make_sorted_array(position, next);
-      mask = (mask << (lead + (base - trail))) >> lead;
-      mask = (next < position) ? ~mask : mask;
-      knocks += (notches & mask).count();
-      position = next;
+      auto knocks = countKnocks(steps);
+      position = (position + steps % base) % base;
 
       if (knocks > 0u) {
         turnover_callback(knocks);
@@ -126,6 +133,47 @@ namespace enigma {
       return position;
     }
     
+    // countKnocks --
+    // Returns the number of notches which would be encountered by advancing
+    // `steps`, without advancing.
+    //
+    [[nodiscard]] std::size_t countKnocks(std::size_t steps) const {
+      auto knocks = (steps / base) * notches.count();
+      auto remainder = steps % base;
+
+      // Rotate the notches such that bit 0 is the position following the
+      // current one, then keep only the `remainder` positions passed over.
+      auto passed = (notches >> (position + 1u)) |
+                    (notches << (base - position - 1u));
+      passed <<= base - remainder;
+      return knocks + passed.count();
+    }
+
+    [[nodiscard]] std::size_t getPosition() const {
+      return position;
+    }
+
+    // setPosition --
+    // Rotate the rotor directly to `pos` without invoking the turnover
+    // callback.
+    //
+    void setPosition(std::size_t pos) {
+      assert(pos < base);
+      position = pos;
+    }
+
+    [[nodiscard]] CipherArray const & getForwardCipher() const {
+      return forward_cipher;
+    }
+
+    [[nodiscard]] CipherArray const & getReverseCipher() const {
+      return reverse_cipher;
+    }
+
+    [[nodiscard]] NotchArray const & getNotches() const {
+      return notches;
+    }
+
     [[nodiscard]] Index doForwardCipher(Index val) const {
       assert(val < base);
       return forward_cipher[(position + val) % base];
@@ -136,6 +184,22 @@ namespace enigma {
       return reverse_cipher[(position + val) % base];
     }
 
+    // undoForwardCipher --
+    // Inverse of `doForwardCipher` at the current position.
+    //
+    [[nodiscard]] Index undoForwardCipher(Index val) const {
+      assert(val < base);
+      return static_cast<Index>((reverse_cipher[val] + base - position) % base);
+    }
+
+    // undoReverseCipher --
+    // Inverse of `doReverseCipher` at the current position.
+    //
+    [[nodiscard]] Index undoReverseCipher(Index val) const {
+      assert(val < base);
+      return static_cast<Index>((forward_cipher[val] + base - position) % base);
+    }
+
   private:
 
     static void ignoreTurnover(std::size_t) {}
@@ -167,6 +231,53 @@ namespace enigma {
   Rotor(T1 &&, T2 &&, deduce_turnover_func_t<T1> = {}) ->
     Rotor<util::array_value_t<T1>, util::array_size_v<T1>>;
 
+  // Knock tables --------------------------------------------------------------
+  // Prefix sums of a rotor's notches over two turns, such that `knocks[i]` is
+  // the number of notches at positions `[0, i)` of the doubled rotor. They
+  // count the notches passed by any advance (as `Rotor::countKnocks`) in two
+  // lookups, for machines which seek by arithmetic rather than by stepping
+  // rotor objects.
+  //
+  // `KnocksT` is indexable with `2 * base + 1` entries (e.g. `std::array`).
+  //
+
+  // fillKnocks --
+  // `notches` - Indexable by code point, true where a notch exists (e.g.
+  //             `std::array<bool, base>` or `std::bitset<base>`).
+  //
+  template<class KnocksT, class NotchesT>
+  constexpr void fillKnocks(KnocksT & knocks, NotchesT const & notches,
+                            std::size_t base) {
+    knocks[0] = 0u;
+    for (auto i = std::size_t{0u}; i < 2u * base; ++i) {
+      knocks[i + 1u] = knocks[i] + (notches[i % base] ? 1u : 0u);
+    }
+  }
+
+  // countKnocks --
+  // Returns the number of notches encountered by advancing `steps` from
+  // `position`.
+  //
+  template<class KnocksT, class StepT>
+  [[nodiscard]] constexpr StepT countKnocks(KnocksT const & knocks,
+                                            std::size_t base,
+                                            std::size_t position,
+                                            StepT steps) {
+    auto whole = (steps / base) * knocks[base];
+    auto partial = knocks[position + steps % base + 1u] -
+                   knocks[position + 1u];
+    return static_cast<StepT>(whole + partial);
+  }
+
+  // hasNotch --
+  // True if the rotor has a notch at `position`.
+  //
+  template<class KnocksT>
+  [[nodiscard]] constexpr bool hasNotch(KnocksT const & knocks,
+                                        std::size_t position) {
+    return knocks[position + 1u] != knocks[position];
+  }
+
   // Enigma Machine class ------------------------------------------------------
   // Contains a rotor assembly and a reflector. Rotors are connected such that
   // each advances the one following it. The reflector is used to reverse the
@@ -185,6 +296,7 @@ namespace enigma {
     using RotorType = Rotor<Index, base>;
     using RotorArray = std::array<RotorType, rotor_count>;
     using ReflectorType = std::array<Index, base>;
+    using PositionArray = std::array<std::size_t, rotor_count>;
 
     static constexpr std::size_t getBase() {
       return base;
@@ -207,13 +319,53 @@ namespace enigma {
     EnigmaMachine(RotorsT && rotors, ReflectorT && reflector):
         rotors(std::forward<RotorsT>(rotors)),
         reflector(std::forward<ReflectorT>(reflector)) {
+      for (auto i = 0u; i < base; ++i) {
+        reflector_inverse[this->reflector[i]] = i;
+      }
+      linkRotors();
+    }
 
-      for (auto i = 0u; i < this->rotors.size() - 1; ++i) {
-        auto & next_rotor = this->rotors[i + 1];
-        auto callback = [&next_rotor](std::size_t knocks) {
-          next_rotor.advance(knocks);
-        };
-        this->rotors[i].setTurnoverCallback(callback);
+    // Copy constructor and assignment --
+    // Turnover callbacks refer to the rotors of the machine which created
+    // them, so they are re-linked to the rotors of the copy.
+    //
+    EnigmaMachine(EnigmaMachine const & other):
+        rotors(other.rotors),
+        reflector(other.reflector),
+        reflector_inverse(other.reflector_inverse) {
+      linkRotors();
+    }
+
+    EnigmaMachine & operator=(EnigmaMachine const & other) {
+      rotors = other.rotors;
+      reflector = other.reflector;
+      reflector_inverse = other.reflector_inverse;
+      linkRotors();
+      return *this;
+    }
+
+    [[nodiscard]] RotorArray const & getRotors() const {
+      return rotors;
+    }
+
+    [[nodiscard]] ReflectorType const & getReflector() const {
+      return reflector;
+    }
+
+    [[nodiscard]] PositionArray getPositions() const {
+      auto positions = PositionArray{};
+      for (auto i = 0u; i < rotor_count; ++i) {
+        positions[i] = rotors[i].getPosition();
+      }
+      return positions;
+    }
+
+    // setPositions --
+    // Set the position of every rotor directly, without turnovers.
+    //
+    void setPositions(PositionArray const & positions) {
+      for (auto i = 0u; i < rotor_count; ++i) {
+        rotors[i].setPosition(positions[i]);
       }
     }
 
@@ -255,10 +407,53 @@ namespace enigma {
       return encode(val);
     }
 
+    // decode --
+    // Inverse of `encode` at the current position. The rotor wiring is only
+    // offset on entry to each rotor, so `encode` is not generally its own
+    // inverse, even with an involutory reflector. Decoding undoes each stage
+    // of `encode` in reverse order.
+    //
+    [[nodiscard]] Index decode(Index val) const {
+
+      // Undo the backwards pass through the rotor assembly.
+      for (auto it = rotors.begin(); it != rotors.end(); ++it) {
+        val = it->undoReverseCipher(val);
+      }
+
+      // Undo the reflector.
+      val = reflector_inverse[val];
+
+      // Undo the forward pass through the rotor assembly.
+      for (auto it = rotors.rbegin(); it != rotors.rend(); ++it) {
+        val = it->undoForwardCipher(val);
+      }
+
+      return val;
+    }
+
+    // decodeNext --
+    // Counterpart to `encodeNext`. Advances the rotor assembly then decodes.
+    //
+    Index decodeNext(Index val) {
+      advance();
+      return decode(val);
+    }
+
   private:
 
+    void linkRotors() {
+      for (auto i = 0u; i < this->rotors.size() - 1; ++i) {
+        auto & next_rotor = this->rotors[i + 1];
+        auto callback = [&next_rotor](std::size_t knocks) {
+          next_rotor.advance(knocks);
+        };
+        this->rotors[i].setTurnoverCallback(callback);
+      }
+    }
+
     RotorArray rotors;
     ReflectorType reflector;
+    ReflectorType reflector_inverse;
   };
 
   // Enigma Machine class deduction guides -------------------------------------
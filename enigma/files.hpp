@@ -0,0 +1,409 @@
+#ifndef ENIGMA_FILES_HPP
+#define ENIGMA_FILES_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <system_error>
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+
+#include "composite.hpp"
+#include "stream.hpp"
+
+namespace enigma::files {
+
+  // File encryption -----------------------------------------------------------
+  // Enciphers files and directory trees in parallel. Each file is enciphered
+  // as `enigma stream` would encipher it (see `encodeStream`), by its own
+  // machine: the base machine with starting positions and offset derived
+  // from a master key and the file's ID, a hash of its output path relative
+  // to the output directory (see `deriveMachine`), so distinct outputs have
+  // distinct keystreams, and deciphering a tree found under the output
+  // directory (`Options::decode`) derives the same machines again.
+  //
+  // Work is planned up front as a list of jobs taken from a shared counter
+  // by a pool of threads. A file larger than the split size becomes several
+  // jobs, each seeking its machine arithmetically to the start of its range
+  // and writing at that offset of a preallocated output. Files smaller than
+  // the batch size are grouped into jobs of up to that many bytes, so a job
+  // covers the open and stat of many small files.
+  //
+
+  struct FileTask {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    std::uint64_t size;
+    std::uint64_t id;
+  };
+
+  // Job struct --
+  // Either `count` whole files from task `first`, or (`count` is zero) the
+  // byte range `[offset, offset + size)` of task `first`.
+  //
+  struct Job {
+    std::size_t first;
+    std::size_t count;
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  struct Options {
+    std::size_t threads = 0u;
+    std::uint64_t split_size = 16u << 20u;
+    std::uint64_t batch_size = 1u << 20u;
+    std::size_t chunk_size = 1u << 16u;
+    bool decode = false;
+  };
+
+  // Progress struct --
+  // Updated by workers as jobs complete; may be read from any thread.
+  //
+  struct Progress {
+    std::atomic<std::uint64_t> bytes = 0u;
+    std::atomic<std::size_t> files = 0u;
+    std::atomic<std::size_t> failed = 0u;
+  };
+
+  // getFileId --
+  // 64-bit FNV-1a hash of `relative`, in generic ('/' separated) form.
+  //
+  [[nodiscard]] inline std::uint64_t
+  getFileId(std::filesystem::path const & relative) {
+    auto hash = std::uint64_t{0xcbf29ce484222325u};
+    for (auto c : relative.generic_string()) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3u;
+    }
+    return hash;
+  }
+
+  // mixKey --
+  // SplitMix64 finaliser, combining a master key with a file ID.
+  //
+  [[nodiscard]] constexpr std::uint64_t mixKey(std::uint64_t master,
+                                               std::uint64_t id) {
+    auto z = master + 0x9e3779b97f4a7c15u * (id | 1u);
+    z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27u)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31u);
+  }
+
+  // deriveMachine --
+  // Returns `machine` with each rotor's position and then an offset of up
+  // to 2^32 symbols taken from the mixed key.
+  //
+  template<class MachineT>
+  [[nodiscard]] MachineT deriveMachine(MachineT machine, std::uint64_t master,
+                                       std::uint64_t id) {
+    auto key = mixKey(master, id);
+    auto positions = typename MachineT::PositionArray{};
+    auto bits = key;
+    for (auto & position : positions) {
+      position = static_cast<std::size_t>(bits % MachineT::getBase());
+      bits /= MachineT::getBase();
+    }
+    machine.setPositions(positions);
+    machine.advance(static_cast<std::size_t>(key >> 32u));
+    return machine;
+  }
+
+  // collectTasks --
+  // Lists the regular files under each of `roots`, which may be files or
+  // directories. A file found under directory `root` is written to the same
+  // relative path under `output / root.filename()`; a file given directly is
+  // written to its name under `output`. Throws
+  // `std::filesystem::filesystem_error`, or `std::invalid_argument` if two
+  // files would be written to the same output or an output is an input.
+  //
+  [[nodiscard]] inline std::vector<FileTask>
+  collectTasks(std::vector<std::filesystem::path> const & roots,
+               std::filesystem::path const & output) {
+    namespace fs = std::filesystem;
+    auto tasks = std::vector<FileTask>{};
+    auto add = [&](fs::directory_entry const & entry,
+                   fs::path const & relative) {
+      tasks.push_back({entry.path(), output / relative, entry.file_size(),
+                       getFileId(relative)});
+    };
+
+    for (auto const & root : roots) {
+      auto entry = fs::directory_entry{root};
+      if (!entry.is_directory()) {
+        add(entry, root.filename());
+        continue;
+      }
+      // The canonical form names a root given as "." or with a trailing
+      // separator.
+      auto name = fs::canonical(root).filename();
+      for (auto const & item : fs::recursive_directory_iterator{root}) {
+        if (item.is_regular_file()) {
+          add(item, name / item.path().lexically_relative(root));
+        }
+      }
+    }
+
+    // Outputs are compared in canonical form, so an output reached through
+    // a link to an input is still caught before it is truncated.
+    auto inputs = std::vector<fs::path>{};
+    auto outputs = std::vector<std::pair<fs::path, std::size_t>>{};
+    for (auto i = std::size_t{0u}; i < tasks.size(); ++i) {
+      inputs.push_back(fs::weakly_canonical(tasks[i].input));
+      outputs.emplace_back(fs::weakly_canonical(tasks[i].output), i);
+    }
+    std::sort(inputs.begin(), inputs.end());
+    std::sort(outputs.begin(), outputs.end());
+    for (auto i = std::size_t{0u}; i < outputs.size(); ++i) {
+      auto const & task = tasks[outputs[i].second];
+      if (std::binary_search(inputs.begin(), inputs.end(), outputs[i].first)) {
+        throw std::invalid_argument("output '" + task.output.string() +
+                                    "' is an input");
+      }
+      if (i > 0u && outputs[i - 1u].first == outputs[i].first) {
+        throw std::invalid_argument(
+          "'" + tasks[outputs[i - 1u].second].input.string() + "' and '" +
+          task.input.string() + "' both write '" + task.output.string() +
+          "'");
+      }
+    }
+    return tasks;
+  }
+
+  // planJobs --
+  // Splits `tasks` into jobs as described above.
+  //
+  [[nodiscard]] inline std::vector<Job>
+  planJobs(std::vector<FileTask> const & tasks, Options const & options) {
+    auto jobs = std::vector<Job>{};
+    auto batch = Job{0u, 0u, 0u, 0u};
+    auto flush = [&] {
+      if (batch.count > 0u) {
+        jobs.push_back(batch);
+      }
+      batch = Job{0u, 0u, 0u, 0u};
+    };
+
+    for (auto i = std::size_t{0u}; i < tasks.size(); ++i) {
+      auto size = tasks[i].size;
+      if (size > options.split_size) {
+        for (auto offset = std::uint64_t{0u}; offset < size;
+             offset += options.split_size) {
+          jobs.push_back({i, 0u, offset,
+                          std::min(options.split_size, size - offset)});
+        }
+        continue;
+      }
+      if (batch.count > 0u && (batch.first + batch.count != i ||
+                               batch.size + size > options.batch_size)) {
+        flush();
+      }
+      if (batch.count == 0u) {
+        batch.first = i;
+      }
+      ++batch.count;
+      batch.size += size;
+    }
+    flush();
+    return jobs;
+  }
+
+  // FileEncoder class ---------------------------------------------------------
+  // Runs planned jobs. `MachineT` is an `EnigmaMachine`; each job enciphers
+  // (or, with `Options::decode`, deciphers) with a `CompositeMachine` made
+  // from the file's derived machine.
+  //
+  template<class MachineT>
+  class FileEncoder {
+  public:
+
+    FileEncoder() = delete;
+
+    FileEncoder(MachineT const & machine, std::uint64_t master,
+                Options const & options):
+        machine(machine), master(master), options(options) {
+      if (this->options.threads == 0u) {
+        this->options.threads =
+          std::max(1u, std::thread::hardware_concurrency());
+      }
+    }
+
+    // run --
+    // Enciphers every task, updating `progress`. Returns a message for each
+    // file which failed; its output may be incomplete.
+    //
+    std::vector<std::string> run(std::vector<FileTask> const & tasks,
+                                 std::vector<Job> const & jobs,
+                                 Progress & progress) const {
+      auto errors = std::vector<std::string>{};
+      auto mutex = std::mutex{};
+      auto fail = [&](FileTask const & task, std::string const & what) {
+        progress.failed.fetch_add(1u, std::memory_order_relaxed);
+        auto lock = std::lock_guard{mutex};
+        errors.push_back(task.input.string() + ": " + what);
+      };
+
+      // Output directories are made once here rather than per file. Outputs
+      // of split files are created at full size before any range is
+      // written, so ranges may be written in any order.
+      auto directories = std::vector<std::filesystem::path>{};
+      for (auto const & task : tasks) {
+        directories.push_back(task.output.parent_path());
+      }
+      std::sort(directories.begin(), directories.end());
+      directories.erase(std::unique(directories.begin(), directories.end()),
+                        directories.end());
+      for (auto const & directory : directories) {
+        auto error = std::error_code{};
+        std::filesystem::create_directories(directory, error);
+      }
+
+      auto split = std::vector<bool>(tasks.size(), false);
+      for (auto const & job : jobs) {
+        if (job.count == 0u && job.offset == 0u) {
+          split[job.first] = prepareOutput(tasks[job.first], fail);
+        }
+      }
+
+      auto next = std::atomic<std::size_t>{0u};
+      auto worker = [&] {
+        auto buffers = Buffers{};
+        for (auto i = next++; i < jobs.size(); i = next++) {
+          auto const & job = jobs[i];
+          if (job.count == 0u) {
+            if (split[job.first]) {
+              encodeRange(tasks[job.first], job.offset, job.size, buffers,
+                          progress, fail);
+            }
+            continue;
+          }
+          for (auto t = job.first; t < job.first + job.count; ++t) {
+            encodeFile(tasks[t], buffers, progress, fail);
+          }
+        }
+      };
+
+      auto pool = std::vector<std::thread>{};
+      for (auto i = 1u; i < options.threads; ++i) {
+        pool.emplace_back(worker);
+      }
+      worker();
+      for (auto & thread : pool) {
+        thread.join();
+      }
+      return errors;
+    }
+
+  private:
+
+    struct Buffers {
+      std::vector<char> bytes;
+      std::vector<std::uint8_t> indices;
+    };
+
+    template<class FailFunc>
+    bool prepareOutput(FileTask const & task, FailFunc & fail) const {
+      auto file = std::ofstream{task.output, std::ios::binary};
+      if (!file) {
+        fail(task, "cannot create '" + task.output.string() + "'");
+        return false;
+      }
+      file.close();
+      auto error = std::error_code{};
+      std::filesystem::resize_file(task.output, task.size, error);
+      if (error) {
+        fail(task, error.message());
+        return false;
+      }
+      return true;
+    }
+
+    template<class FailFunc>
+    void encodeFile(FileTask const & task, Buffers & buffers,
+                    Progress & progress, FailFunc & fail) const {
+      auto is = std::ifstream{task.input, std::ios::binary};
+      auto os = std::ofstream{task.output, std::ios::binary};
+      if (!is || !os) {
+        fail(task, "cannot open input or output");
+        return;
+      }
+      if (encode(task, 0u, task.size, is, os, buffers, progress)) {
+        progress.files.fetch_add(1u, std::memory_order_relaxed);
+      } else {
+        fail(task, "read or write failed");
+      }
+    }
+
+    template<class FailFunc>
+    void encodeRange(FileTask const & task, std::uint64_t offset,
+                     std::uint64_t size, Buffers & buffers,
+                     Progress & progress, FailFunc & fail) const {
+      auto is = std::ifstream{task.input, std::ios::binary};
+      auto os = std::fstream{task.output,
+                             std::ios::binary | std::ios::in | std::ios::out};
+      is.seekg(static_cast<std::streamoff>(offset));
+      os.seekp(static_cast<std::streamoff>(offset));
+      if (!is || !os) {
+        fail(task, "cannot open input or output");
+        return;
+      }
+      if (!encode(task, offset, size, is, os, buffers, progress)) {
+        fail(task, "read or write failed");
+      } else if (offset + size == task.size) {
+        progress.files.fetch_add(1u, std::memory_order_relaxed);
+      }
+    }
+
+    // encode --
+    // Enciphers `size` bytes from `is` to `os`, being bytes `offset`
+    // onwards of the file of `task`.
+    //
+    bool encode(FileTask const & task, std::uint64_t offset,
+                std::uint64_t size, std::istream & is, std::ostream & os,
+                Buffers & buffers, Progress & progress) const {
+      auto derived = deriveMachine(machine, master, task.id);
+      derived.advance(static_cast<std::size_t>(offset));
+      auto composite = CompositeMachine(derived);
+
+      auto & bytes = buffers.bytes;
+      while (size > 0u) {
+        auto count = static_cast<std::size_t>(
+          std::min<std::uint64_t>(size, options.chunk_size));
+        bytes.resize(count);
+        is.read(bytes.data(), static_cast<std::streamsize>(count));
+        if (static_cast<std::size_t>(is.gcount()) != count) {
+          return false;
+        }
+        mapChunk(bytes, buffers.indices);
+        if (options.decode) {
+          auto decoder = Decoder{composite};
+          encodeChunk(decoder, buffers.indices);
+        } else {
+          encodeChunk(composite, buffers.indices);
+        }
+        unmapChunk(buffers.indices, bytes);
+        os.write(bytes.data(), static_cast<std::streamsize>(count));
+        progress.bytes.fetch_add(count, std::memory_order_relaxed);
+        size -= count;
+      }
+      os.flush();
+      return static_cast<bool>(os);
+    }
+
+    MachineT machine;
+    std::uint64_t master;
+    Options options;
+  };
+
+}
+
+#endif // ENIGMA_FILES_HPP
@@ -0,0 +1,478 @@
+#ifndef ENIGMA_JIT_HPP
+#define ENIGMA_JIT_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <array>
+
+#include "enigma.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define ENIGMA_JIT_X86_64 1
+#endif
+
+namespace enigma {
+
+  // Assembler class -----------------------------------------------------------
+  // Emits the handful of x86-64 instructions needed by `JitKernel`. Registers
+  // are numbered as in the instruction encoding (rax = 0 ... r15 = 15).
+  //
+  class Assembler {
+  public:
+
+    enum Register : std::uint8_t {
+      rax = 0, rcx, rdx, rbx, rsp, rbp, rsi, rdi,
+      r8, r9, r10, r11, r12, r13, r14, r15
+    };
+
+    [[nodiscard]] std::vector<std::uint8_t> const & getCode() const {
+      return code;
+    }
+
+    [[nodiscard]] std::size_t getSize() const {
+      return code.size();
+    }
+
+    void push(Register reg) {
+      rexIf(reg >= 8u, 0x41u);
+      emit(0x50u + (reg & 7u));
+    }
+
+    void pop(Register reg) {
+      rexIf(reg >= 8u, 0x41u);
+      emit(0x58u + (reg & 7u));
+    }
+
+    void ret() {
+      emit(0xC3u);
+    }
+
+    // lea dst, [rip + disp32] -- Returns the offset of the displacement.
+    std::size_t leaRip(Register dst) {
+      emit(0x48u | ((dst >> 3u) << 2u), 0x8Du, modrm(0u, dst, 5u));
+      return emit32(0u);
+    }
+
+    // add dst, src (64-bit)
+    void add64(Register dst, Register src) {
+      emit(0x48u | ((src >> 3u) << 2u) | (dst >> 3u), 0x01u,
+           modrm(3u, src, dst));
+    }
+
+    // cmp lhs, rhs (64-bit)
+    void cmp64(Register lhs, Register rhs) {
+      emit(0x48u | ((rhs >> 3u) << 2u) | (lhs >> 3u), 0x39u,
+           modrm(3u, rhs, lhs));
+    }
+
+    // inc reg (64-bit)
+    void inc64(Register reg) {
+      emit(0x48u | (reg >> 3u), 0xFFu, modrm(3u, 0u, reg));
+    }
+
+    // inc reg (32-bit)
+    void inc32(Register reg) {
+      rexIf(reg >= 8u, 0x41u);
+      emit(0xFFu, modrm(3u, 0u, reg));
+    }
+
+    // xor reg, reg (32-bit, zeroes the full register)
+    void zero32(Register reg) {
+      rexIf(reg >= 8u, 0x45u);
+      emit(0x31u, modrm(3u, reg, reg));
+    }
+
+    // cmp reg, imm32 (32-bit)
+    void cmp32(Register reg, std::uint32_t imm) {
+      rexIf(reg >= 8u, 0x41u);
+      emit(0x81u, modrm(3u, 7u, reg));
+      emit32(imm);
+    }
+
+    // add dst, src (32-bit)
+    void add32(Register dst, Register src) {
+      rexIf(src >= 8u || dst >= 8u,
+            0x40u | ((src >> 3u) << 2u) | (dst >> 3u));
+      emit(0x01u, modrm(3u, src, dst));
+    }
+
+    // mov dst, dword [base + disp8]
+    void load32(Register dst, Register base, std::uint8_t disp) {
+      rexIf(dst >= 8u || base >= 8u,
+            0x40u | ((dst >> 3u) << 2u) | (base >> 3u));
+      emit(0x8Bu, modrm(1u, dst, base), disp);
+    }
+
+    // mov dword [base + disp8], src
+    void store32(Register base, std::uint8_t disp, Register src) {
+      rexIf(src >= 8u || base >= 8u,
+            0x40u | ((src >> 3u) << 2u) | (base >> 3u));
+      emit(0x89u, modrm(1u, src, base), disp);
+    }
+
+    // movzx eax, byte [rdi]
+    void loadByteEaxRdi() {
+      emit(0x0Fu, 0xB6u, 0x07u);
+    }
+
+    // mov byte [rdi], al
+    void storeByteRdiAl() {
+      emit(0x88u, 0x07u);
+    }
+
+    // movzx eax, byte [r8 + rax + disp32]
+    void lookupEax(std::uint32_t disp) {
+      emit(0x41u, 0x0Fu, 0xB6u, modrm(2u, 0u, 4u), 0x00u);
+      emit32(disp);
+    }
+
+    // cmp byte [r8 + index + disp32], 0
+    void testTable(Register index, std::uint32_t disp) {
+      emit(0x41u | ((index >> 3u) << 1u), 0x80u, modrm(2u, 7u, 4u),
+           static_cast<std::uint8_t>(((index & 7u) << 3u)));
+      emit32(disp);
+      emit(0x00u);
+    }
+
+    // Jumps --
+    // Each returns the offset of its rel32 field, to be fixed with `bind`.
+
+    std::size_t jmp() {
+      emit(0xE9u);
+      return emit32(0u);
+    }
+
+    std::size_t je() {
+      emit(0x0Fu, 0x84u);
+      return emit32(0u);
+    }
+
+    std::size_t jne() {
+      emit(0x0Fu, 0x85u);
+      return emit32(0u);
+    }
+
+    std::size_t jae() {
+      emit(0x0Fu, 0x83u);
+      return emit32(0u);
+    }
+
+    // bind --
+    // Point the rel32 field at `fixup` to `target` (a code offset).
+    //
+    void bind(std::size_t fixup, std::size_t target) {
+      auto rel = static_cast<std::int32_t>(target - (fixup + 4u));
+      std::memcpy(code.data() + fixup, &rel, sizeof(rel));
+    }
+
+    void align(std::size_t alignment) {
+      while (code.size() % alignment != 0u) {
+        emit(0xCCu);
+      }
+    }
+
+    void append(std::uint8_t const * data, std::size_t size) {
+      code.insert(code.end(), data, data + size);
+    }
+
+  private:
+
+    static constexpr std::uint8_t modrm(unsigned mod, unsigned reg,
+                                        unsigned rm) {
+      return static_cast<std::uint8_t>((mod << 6u) | ((reg & 7u) << 3u) |
+                                       (rm & 7u));
+    }
+
+    template<class ... Bytes>
+    void emit(Bytes ... bytes) {
+      (code.push_back(static_cast<std::uint8_t>(bytes)), ...);
+    }
+
+    void rexIf(bool condition, unsigned rex) {
+      if (condition) {
+        emit(rex);
+      }
+    }
+
+    std::size_t emit32(std::uint32_t value) {
+      auto offset = code.size();
+      for (auto i = 0u; i < 4u; ++i) {
+        emit((value >> (8u * i)) & 0xFFu);
+      }
+      return offset;
+    }
+
+    std::vector<std::uint8_t> code;
+  };
+
+  // JitKernel class -----------------------------------------------------------
+  // Machine code specialised to the wiring, notches and reflector of an
+  // `EnigmaMachine`. `encodeNext` gives exactly the same results as calling
+  // `EnigmaMachine::encodeNext` on each element of a buffer, but with:
+  //
+  //  - every table embedded in the code and doubled in length, so rotor
+  //    offsets are applied without a modulo;
+  //  - rotor positions held in registers for the whole buffer;
+  //  - turnover checks compiled against the known notch positions, with the
+  //    rare carry into the next rotor moved out of the main loop.
+  //
+  // Compilation is only attempted on x86-64 Linux for 8-bit code points,
+  // `base` of at most 128 and at most 8 rotors; otherwise (or if executable
+  // memory cannot be mapped) `isCompiled` is false and `encodeNext` falls
+  // back to the generic machine. The kernel holds no reference to the
+  // machine it was built from, but must only be used with machines sharing
+  // its wiring.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class JitKernel {
+  public:
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using Index = IndexT;
+
+    explicit JitKernel(MachineType const & machine) {
+#if defined(ENIGMA_JIT_X86_64)
+      if constexpr (is_supported) {
+        compile(machine);
+      }
+#endif
+      (void)machine;
+    }
+
+    JitKernel(JitKernel const &) = delete;
+    JitKernel & operator=(JitKernel const &) = delete;
+
+    ~JitKernel() {
+#if defined(ENIGMA_JIT_X86_64)
+      if (memory != nullptr) {
+        ::munmap(memory, memory_size);
+      }
+#endif
+    }
+
+    [[nodiscard]] bool isCompiled() const {
+      return function != nullptr;
+    }
+
+    // encodeNext --
+    // Advance `machine` and encode each of the `size` values at `data` in
+    // place.
+    //
+    void encodeNext(MachineType & machine, Index * data,
+                    std::size_t size) const {
+      if (!isCompiled()) {
+        for (auto i = std::size_t{0u}; i < size; ++i) {
+          data[i] = machine.encodeNext(data[i]);
+        }
+        return;
+      }
+
+      auto positions = machine.getPositions();
+      auto state = std::array<std::uint32_t, rotor_count>{};
+      for (auto i = 0u; i < rotor_count; ++i) {
+        state[i] = static_cast<std::uint32_t>(positions[i]);
+      }
+
+      function(reinterpret_cast<std::uint8_t *>(data), size, state.data());
+
+      for (auto i = 0u; i < rotor_count; ++i) {
+        positions[i] = state[i];
+      }
+      machine.setPositions(positions);
+    }
+
+  private:
+
+    using Function = void (*)(std::uint8_t *, std::size_t, std::uint32_t *);
+    using Register = Assembler::Register;
+
+    static constexpr bool is_supported =
+      std::is_same_v<IndexT, std::uint8_t> && base <= 128u &&
+      rotor_count >= 1u && rotor_count <= 8u;
+
+    // Each table is indexed by `position + value`, possibly by any byte value
+    // for the first rotor, so is repeated to cover every such index.
+    static constexpr std::size_t table_size = 256u + base;
+
+    // Rotors with more notches than this are checked with a table lookup
+    // instead of a chain of compares.
+    static constexpr std::size_t max_unrolled_notches = 4u;
+
+#if defined(ENIGMA_JIT_X86_64)
+    void compile(MachineType const & machine) {
+      static constexpr Register position_registers[] = {
+        Assembler::r9, Assembler::r10, Assembler::r11, Assembler::rbx,
+        Assembler::r12, Assembler::r13, Assembler::r14, Assembler::r15
+      };
+
+      auto const & rotors = machine.getRotors();
+
+      // Data layout: forward tables, reverse tables, reflector, notches.
+      auto forward_offset = [](std::size_t i) {
+        return static_cast<std::uint32_t>(i * table_size);
+      };
+      auto reverse_offset = [](std::size_t i) {
+        return static_cast<std::uint32_t>((rotor_count + i) * table_size);
+      };
+      auto reflector_offset = static_cast<std::uint32_t>(
+        2u * rotor_count * table_size);
+      auto notch_offset = [](std::size_t i) {
+        return static_cast<std::uint32_t>((2u * rotor_count + 1u + i) *
+                                          table_size);
+      };
+
+      auto data = std::vector<std::uint8_t>(
+        (3u * rotor_count + 1u) * table_size, 0u);
+      auto fill = [&](std::uint32_t offset, auto const & table) {
+        for (auto j = 0u; j < table_size; ++j) {
+          data[offset + j] = static_cast<std::uint8_t>(table[j % base]);
+        }
+      };
+      for (auto i = 0u; i < rotor_count; ++i) {
+        fill(forward_offset(i), rotors[i].getForwardCipher());
+        fill(reverse_offset(i), rotors[i].getReverseCipher());
+        for (auto j = 0u; j < base; ++j) {
+          data[notch_offset(i) + j] = rotors[i].getNotches()[j] ? 1u : 0u;
+        }
+      }
+      fill(reflector_offset, machine.getReflector());
+
+      // Prologue --
+      // rdi = data, rsi = data + size, rdx = positions, r8 = tables.
+      auto a = Assembler{};
+      for (auto i = 0u; i < rotor_count; ++i) {
+        auto reg = position_registers[i];
+        if (reg == Assembler::rbx || reg >= Assembler::r12) {
+          a.push(reg);
+        }
+      }
+      auto tables_fixup = a.leaRip(Assembler::r8);
+      a.add64(Assembler::rsi, Assembler::rdi);
+      for (auto i = 0u; i < rotor_count; ++i) {
+        a.load32(position_registers[i], Assembler::rdx,
+                 static_cast<std::uint8_t>(4u * i));
+      }
+
+      // Main loop: step the first rotor, then encode one value --
+      auto carry_fixups = std::vector<std::vector<std::size_t>>(rotor_count);
+      auto emit_step = [&](std::size_t i) {
+        auto reg = position_registers[i];
+        a.inc32(reg);
+        a.cmp32(reg, base);
+        auto no_wrap = a.jne();
+        a.zero32(reg);
+        a.bind(no_wrap, a.getSize());
+
+        if (i + 1u == rotor_count) {
+          return;
+        }
+
+        auto const & notches = rotors[i].getNotches();
+        if (notches.count() > max_unrolled_notches) {
+          a.testTable(reg, notch_offset(i));
+          carry_fixups[i].push_back(a.jne());
+          return;
+        }
+        for (auto j = 0u; j < base; ++j) {
+          if (notches[j]) {
+            a.cmp32(reg, j);
+            carry_fixups[i].push_back(a.je());
+          }
+        }
+      };
+
+      auto loop = a.getSize();
+      a.cmp64(Assembler::rdi, Assembler::rsi);
+      auto done_fixup = a.jae();
+      emit_step(0u);
+
+      auto encode = a.getSize();
+      a.loadByteEaxRdi();
+      for (auto i = 0u; i < rotor_count; ++i) {
+        a.add32(Assembler::rax, position_registers[i]);
+        a.lookupEax(forward_offset(i));
+      }
+      a.lookupEax(reflector_offset);
+      for (auto i = rotor_count; i-- > 0u;) {
+        a.add32(Assembler::rax, position_registers[i]);
+        a.lookupEax(reverse_offset(i));
+      }
+      a.storeByteRdiAl();
+      a.inc64(Assembler::rdi);
+      a.bind(a.jmp(), loop);
+
+      // Carries: rotor `i` reached a notch, step rotor `i + 1` --
+      for (auto i = 0u; i + 1u < rotor_count; ++i) {
+        auto target = a.getSize();
+        for (auto fixup : carry_fixups[i]) {
+          a.bind(fixup, target);
+        }
+        emit_step(i + 1u);
+        a.bind(a.jmp(), encode);
+      }
+
+      // Epilogue --
+      a.bind(done_fixup, a.getSize());
+      for (auto i = 0u; i < rotor_count; ++i) {
+        a.store32(Assembler::rdx, static_cast<std::uint8_t>(4u * i),
+                  position_registers[i]);
+      }
+      for (auto i = rotor_count; i-- > 0u;) {
+        auto reg = position_registers[i];
+        if (reg == Assembler::rbx || reg >= Assembler::r12) {
+          a.pop(reg);
+        }
+      }
+      a.ret();
+
+      a.align(64u);
+      a.bind(tables_fixup, a.getSize());
+      a.append(data.data(), data.size());
+
+      install(a.getCode());
+    }
+
+    // install --
+    // Copy `code` into fresh pages and make them executable. Pages are never
+    // writable and executable at the same time.
+    //
+    void install(std::vector<std::uint8_t> const & code) {
+      auto size = code.size();
+      auto mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mapped == MAP_FAILED) {
+        return;
+      }
+
+      std::memcpy(mapped, code.data(), size);
+      if (::mprotect(mapped, size, PROT_READ | PROT_EXEC) != 0) {
+        ::munmap(mapped, size);
+        return;
+      }
+
+      memory = mapped;
+      memory_size = size;
+      function = reinterpret_cast<Function>(mapped);
+    }
+#endif
+
+    void * memory = nullptr;
+    std::size_t memory_size = 0u;
+    Function function = nullptr;
+  };
+
+  // JitKernel class deduction guides ------------------------------------------
+
+  template<class T> JitKernel(T const &) ->
+    JitKernel<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_JIT_HPP
@@ -0,0 +1,265 @@
+#ifndef ENIGMA_KEYSTREAM_HPP
+#define ENIGMA_KEYSTREAM_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <condition_variable>
+#include <algorithm>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <array>
+#include <mutex>
+
+#include "composite.hpp"
+#include "enigma.hpp"
+#include "ring.hpp"
+
+namespace enigma {
+
+  // Keystream class -----------------------------------------------------------
+  // Splits an `EnigmaMachine` across two threads for streaming. A producer
+  // thread runs ahead of the encoder, evolving the machine state and cutting
+  // it into segments: runs of steps during which only the first rotor moves.
+  // Each segment holds the first rotor's starting position, its length and the
+  // inner composite for that run (see `CompositeMachine`). Segments are passed
+  // through a bounded lock-free ring to the consuming thread, which applies
+  // them to incoming data with three table lookups per symbol and never
+  // touches stepping or composite rebuilds.
+  //
+  // A thread which finds the ring full (producer) or empty (consumer) spins
+  // briefly, then sleeps: the consumer until a segment is pushed, the
+  // producer until the ring has drained to half full, so that it is woken
+  // once per many segments. The other side takes the lock to wake it only
+  // when it is asleep, so the ring stays lock-free while both keep up, and
+  // an idle input costs no CPU.
+  //
+  // The consumer side (`advance`, `encode`, `encodeNext`) may only be used by
+  // one thread at a time. Output is identical to `EnigmaMachine::encodeNext`
+  // on a copy of the machine given to the constructor.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class Keystream {
+  public:
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using Index = IndexT;
+    using CipherArray = std::array<Index, base>;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    Keystream() = delete;
+
+    explicit Keystream(MachineType const & machine):
+        producer_machine(machine) {
+      auto const & first = machine.getRotors()[0];
+      for (auto i = 0u; i < 2u * base; ++i) {
+        first_forward[i] = first.getForwardCipher()[i % base];
+        first_reverse[i] = first.getReverseCipher()[i % base];
+      }
+      producer = std::thread([this] { produce(); });
+    }
+
+    Keystream(Keystream const &) = delete;
+    Keystream & operator=(Keystream const &) = delete;
+
+    ~Keystream() {
+      running.store(false, std::memory_order_relaxed);
+      wake(producer_waiting);
+      producer.join();
+    }
+
+    void advance() {
+      if (remaining == 0u) {
+        nextSegment();
+      }
+      step();
+    }
+
+    Index encodeNext(Index val) {
+      if (remaining == 0u) {
+        nextSegment();
+      }
+      auto result = encode(val);
+      step();
+      return result;
+    }
+
+    // encodeNext --
+    // Batch form of `encodeNext`, encoding `[first, last)` to `out` one
+    // segment at a time.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      while (first != last) {
+        if (remaining == 0u) {
+          nextSegment();
+        }
+        auto const & inner = segment->inner;
+        for (; remaining > 0u && first != last; ++first, ++out) {
+          auto val = first_forward[position + static_cast<Index>(*first)];
+          *out = first_reverse[position + inner[val]];
+          step();
+        }
+      }
+      return out;
+    }
+
+    // getBacklog --
+    // Number of segments computed ahead of the consumer.
+    //
+    [[nodiscard]] std::size_t getBacklog() const {
+      return ring.getSize();
+    }
+
+  private:
+
+    struct Segment {
+      std::size_t first = 0u;
+      std::size_t length = 0u;
+      CipherArray inner = {};
+    };
+
+    // Segments are capped so the consumer is never starved by a machine
+    // whose first rotor carries rarely (or never).
+    static constexpr std::size_t max_segment = 4u * base;
+
+    // Yields before a waiting thread sleeps.
+    static constexpr unsigned spin_limit = 64u;
+
+    [[nodiscard]] Index encode(Index val) const {
+      assert(val < base);
+      auto inner = segment->inner[first_forward[position + val]];
+      return first_reverse[position + inner];
+    }
+
+    void step() {
+      --remaining;
+      if (++position == base) {
+        position = 0u;
+      }
+    }
+
+    void nextSegment() {
+      if (segment != nullptr) {
+        ring.pop();
+        if (ring.getSize() <= ring.getCapacity() / 2u) {
+          wake(producer_waiting);
+        }
+      }
+      for (auto spins = 0u; (segment = ring.front()) == nullptr; ++spins) {
+        if (spins < spin_limit) {
+          std::this_thread::yield();
+        } else {
+          sleep(consumer_waiting, [this] { return ring.getSize() > 0u; });
+        }
+      }
+      position = segment->first;
+      remaining = segment->length;
+    }
+
+    // sleep --
+    // Blocks until `ready` holds, with `waiting` set so that `wake` on the
+    // other thread notifies. The fences pair with those in `wake`: either
+    // `ready` sees the other thread's change or `wake` sees `waiting`.
+    //
+    template<class ReadyFunc>
+    void sleep(std::atomic<bool> & waiting, ReadyFunc ready) {
+      auto lock = std::unique_lock{mutex};
+      waiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      wakeup.wait(lock, ready);
+      waiting.store(false, std::memory_order_relaxed);
+    }
+
+    // wake --
+    // Called after a change to the ring or `running`; wakes the other
+    // thread if it sleeps on `waiting`.
+    //
+    void wake(std::atomic<bool> & waiting) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (waiting.load(std::memory_order_relaxed)) {
+        auto lock = std::lock_guard{mutex};
+        wakeup.notify_all();
+      }
+    }
+
+    void produce() {
+      auto const notches =
+        producer_machine.getMachine().getRotors()[0].getNotches();
+      auto next = Segment{};
+
+      while (running.load(std::memory_order_relaxed)) {
+        producer_machine.advance();
+        next.first = producer_machine.getPositions()[0];
+        next.inner = producer_machine.getInnerComposite();
+
+        // Extend the run over every following step which does not carry.
+        auto length = std::size_t{1u};
+        while (length < max_segment &&
+               (rotor_count == 1u ||
+                !notches[(next.first + length) % base])) {
+          ++length;
+        }
+        next.length = length;
+        if (length > 1u) {
+          producer_machine.advance(length - 1u);
+        }
+
+        for (auto spins = 0u; !ring.tryPush(next); ++spins) {
+          if (!running.load(std::memory_order_relaxed)) {
+            return;
+          }
+          if (spins < spin_limit) {
+            std::this_thread::yield();
+          } else {
+            sleep(producer_waiting, [this] {
+              return ring.getSize() <= ring.getCapacity() / 2u ||
+                     !running.load(std::memory_order_relaxed);
+            });
+          }
+        }
+        // Only a push into an empty ring can find the consumer asleep.
+        if (ring.getSize() == 1u) {
+          wake(consumer_waiting);
+        }
+      }
+    }
+
+    // Consumer state.
+    std::array<Index, 2u * base> first_forward;
+    std::array<Index, 2u * base> first_reverse;
+    Segment const * segment = nullptr;
+    std::size_t position = 0u;
+    std::size_t remaining = 0u;
+
+    // Producer state.
+    CompositeMachine<IndexT, base, rotor_count> producer_machine;
+    SpscRing<Segment, 256u> ring;
+    std::atomic<bool> running = true;
+
+    // Shared by both threads for sleeping (see `sleep` and `wake`).
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::atomic<bool> producer_waiting = false;
+    std::atomic<bool> consumer_waiting = false;
+
+    std::thread producer;
+  };
+
+  // Keystream class deduction guides ------------------------------------------
+
+  template<class T> Keystream(T const &) ->
+    Keystream<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_KEYSTREAM_HPP
@@ -2,98 +2,424 @@
 #error Minimum language standard requirement not met (C++17).
 #endif
 
+#include <condition_variable>
+#include <system_error>
+#include <filesystem>
 #include <algorithm>
+#include <stdexcept>
 #include <iostream>
 #include <iterator>
-#include <bitset>
+#include <optional>
+#include <fstream>
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+#include <vector>
 #include <chrono>
+#include <thread>
+#include <mutex>
 
+#include "keystream.hpp"
+#include "composite.hpp"
+#include "catalog.hpp"
 #include "enigma.hpp"
-#include "util.hpp"
-
-// Rotor Wiring Tables ---------------------------------------------------------
-// Numbers denote the letters of the latin alphabet (0 to 25). A letter at
-// index `i` maps to (is substituted with) the value of `cipher[i]`.
-// Source:
-// https://en.wikipedia.org/wiki/Enigma_rotor_details#Rotor_wiring_tables
-
-static auto const cipherI = util::make_array_of<std::uint8_t>(
-  0x04, 0x0A, 0x0C, 0x05, 0x0B, 0x06, 0x03, 0x10, 0x15, 0x19, 0x0D, 0x13, 0x0E,
-  0x16, 0x18, 0x07, 0x17, 0x14, 0x12, 0x0F, 0x00, 0x08, 0x01, 0x11, 0x02, 0x09
-);
-
-static auto const cipherII = util::make_array_of<std::uint8_t>(
-  0x00, 0x09, 0x03, 0x0A, 0x12, 0x08, 0x11, 0x14, 0x17, 0x01, 0x0B, 0x07, 0x16,
-  0x13, 0x0C, 0x02, 0x10, 0x06, 0x19, 0x0D, 0x0F, 0x18, 0x05, 0x15, 0x0E, 0x04
-);
-
-static auto const cipherIII = util::make_array_of<std::uint8_t>(
-  0x01, 0x03, 0x05, 0x07, 0x09, 0x0B, 0x02, 0x0F, 0x11, 0x13, 0x17, 0x15, 0x19,
-  0x0D, 0x18, 0x04, 0x08, 0x16, 0x06, 0x00, 0x0A, 0x0C, 0x14, 0x12, 0x10, 0x0E
-);
-
-static auto const reflectorB = util::make_array_of<std::uint8_t>(
-  0x18, 0x11, 0x14, 0x07, 0x10, 0x12, 0x0B, 0x03, 0x0F, 0x17, 0x0D, 0x06, 0x0E,
-  0x0A, 0x0C, 0x08, 0x04, 0x01, 0x05, 0x19, 0x02, 0x16, 0x15, 0x09, 0x00, 0x13
-);
-
-// Rotor Notch Tables ----------------------------------------------------------
-// Bits indicate which code points on a rotor have notches. Declared in
-// right-to-left order, such that far right bits correspond to the code point
-// for the letter "A".
-// Source:
-// https://en.wikipedia.org/wiki/Enigma_rotor_details#Turnover_notch_positions
-
-static auto const notchesI = std::bitset<cipherI.size()>{
-  "00000000100000000000000000"
-};
-
-static auto const notchesII = std::bitset<cipherII.size()>{
-  "00000000000000000000100000"
-};
-
-static auto const notchesIII = std::bitset<cipherIII.size()>{
-  "00010000000000000000000000"
-};
+#include "metrics.hpp"
+#include "files.hpp"
+#include "stream.hpp"
+#include "pipe.hpp"
+#include "spec.hpp"
+#include "trace.hpp"
 
 // -----------------------------------------------------------------------------
 
-int main() {
+namespace {
 
   using namespace enigma;
 
-  // Initialise the Enigma machine --
+  auto makeRotor(catalog::RotorWiring const & wiring) {
+    return Rotor{wiring.forward, wiring.reverse, wiring.notches};
+  }
 
-  auto machine = EnigmaMachine{
-    std::array{
-      Rotor{cipherIII, notchesIII},
-      Rotor{cipherII, notchesII},
-      Rotor{cipherI, notchesI}
-    },
-    reflectorB
-  };
+  // makeMachine --
+  // Rotors III, II and I (III fastest) with reflector B, from the
+  // historical catalog.
+  //
+  auto makeMachine() {
+    return EnigmaMachine{
+      std::array{
+        makeRotor(catalog::rotorIII),
+        makeRotor(catalog::rotorII),
+        makeRotor(catalog::rotorI)
+      },
+      catalog::reflectorB
+    };
+  }
 
-  using MachineType = decltype(machine);
-  using SystemClock = std::chrono::system_clock;
+  // runShuffle --
+  // Shuffles a sequence using the PRNG adaptor for a machine seeded from the
+  // system clock.
+  //
+  int runShuffle() {
 
-  auto seed = SystemClock::now().time_since_epoch().count();
-  machine.advance(seed);
+    // Initialise the Enigma machine --
 
-  // Shuffle using PRNG adaptor for Enigma machine --
+    auto machine = makeMachine();
 
-  using SeedLimits = std::numeric_limits<decltype(seed)>;
-  seed /= (SeedLimits::max() / MachineType::getBase());
+    using MachineType = decltype(machine);
+    using SystemClock = std::chrono::system_clock;
 
-  auto items = std::array<int, 10u>{};
-  std::iota(items.begin(), items.end(), 1);
+    auto seed = SystemClock::now().time_since_epoch().count();
+    machine.advance(seed);
 
-  auto os_iter = std::ostream_iterator<int>(std::cout, ", ");
-  std::copy(items.begin(), items.end(), os_iter);
-  std::cout << "\n";
+    // Shuffle using PRNG adaptor for Enigma machine --
 
-  std::shuffle(items.begin(), items.end(), Generator(machine, seed));
-  std::copy(items.begin(), items.end(), os_iter);
-  std::cout << "\n";
+    using SeedLimits = std::numeric_limits<decltype(seed)>;
+    seed /= (SeedLimits::max() / MachineType::getBase());
 
-  return 0;
+    auto items = std::array<int, 10u>{};
+    std::iota(items.begin(), items.end(), 1);
+
+    auto os_iter = std::ostream_iterator<int>(std::cout, ", ");
+    std::copy(items.begin(), items.end(), os_iter);
+    std::cout << "\n";
+
+    std::shuffle(items.begin(), items.end(), Generator(machine, seed));
+    std::copy(items.begin(), items.end(), os_iter);
+    std::cout << "\n";
+
+    return 0;
+  }
+
+  // runStream --
+  // Enciphers standard input to standard output.
+  // Usage: enigma stream [--offset N] [--chunk BYTES] [--trace FILE]
+  //                      [--metrics-port PORT] [--precompute]
+  //                      [--spec FILE] [--pipe] [--decode]
+  //
+  // `--precompute` moves machine stepping onto a second thread (see
+  // `Keystream`). `--spec` replaces the built-in machine with one described
+  // in FILE (see `spec::parse`). `--pipe` reads and writes the descriptors
+  // directly, splicing output into a pipe (see `encodePipe`), and enciphers
+  // the built-in machine through a `CompositeMachine`; `--chunk` then has
+  // no effect. `--decode` deciphers what was enciphered with the same
+  // options (see `Decoder`); with `--spec`, a letter enciphered to a symbol
+  // without case comes back in the case the alphabet lists.
+  //
+  int runStream(std::vector<std::string> const & args) {
+    auto offset = std::uint64_t{0u};
+    auto chunk_size = std::size_t{1u << 16u};
+    auto trace_path = std::string{};
+    auto metrics_port = 0ul;
+    auto precompute = false;
+    auto spec_path = std::string{};
+    auto pipe = false;
+    auto decode = false;
+
+    for (auto i = 0u; i < args.size(); ++i) {
+      auto has_value = i + 1u < args.size();
+      if (args[i] == "--offset" && has_value) {
+        offset = std::strtoull(args[++i].c_str(), nullptr, 10);
+      } else if (args[i] == "--chunk" && has_value) {
+        chunk_size = std::strtoull(args[++i].c_str(), nullptr, 10);
+      } else if (args[i] == "--trace" && has_value) {
+        trace_path = args[++i];
+      } else if (args[i] == "--metrics-port" && has_value) {
+        metrics_port = std::strtoul(args[++i].c_str(), nullptr, 10);
+      } else if (args[i] == "--precompute") {
+        precompute = true;
+      } else if (args[i] == "--spec" && has_value) {
+        spec_path = args[++i];
+      } else if (args[i] == "--pipe") {
+        pipe = true;
+      } else if (args[i] == "--decode") {
+        decode = true;
+      } else {
+        std::cerr << "enigma stream: unknown option '" << args[i] << "'\n";
+        return 1;
+      }
+    }
+
+    if (chunk_size == 0u) {
+      std::cerr << "enigma stream: chunk size must be non-zero\n";
+      return 1;
+    }
+
+    if (precompute && !spec_path.empty()) {
+      std::cerr << "enigma stream: --precompute does not support --spec\n";
+      return 1;
+    }
+
+#if !defined(ENIGMA_PIPE_SPLICE)
+    if (pipe) {
+      std::cerr << "enigma stream: --pipe is not supported on this platform\n";
+      return 1;
+    }
+#endif
+
+#if !defined(ENIGMA_METRICS_HAS_SOCKETS)
+    if (metrics_port != 0ul) {
+      std::cerr << "enigma stream: --metrics-port is not supported on this "
+                   "platform\n";
+      return 1;
+    }
+#endif
+
+    if (metrics_port > 65535ul) {
+      std::cerr << "enigma stream: metrics port must be at most 65535\n";
+      return 1;
+    }
+
+    if (pipe && precompute) {
+      std::cerr << "enigma stream: --pipe does not support --precompute\n";
+      return 1;
+    }
+
+    if (decode && precompute) {
+      std::cerr << "enigma stream: --decode does not support --precompute\n";
+      return 1;
+    }
+
+    auto spec = std::optional<spec::Spec>{};
+    if (!spec_path.empty()) {
+      auto file = std::ifstream{spec_path};
+      if (!file) {
+        std::cerr << "enigma stream: cannot open '" << spec_path << "'\n";
+        return 1;
+      }
+      try {
+        spec = spec::parse(file);
+      } catch (std::invalid_argument const & error) {
+        std::cerr << "enigma stream: " << spec_path << ": " << error.what()
+                  << "\n";
+        return 1;
+      }
+    }
+
+    if (!trace_path.empty()) {
+      trace::Recorder::getInstance().enable();
+    }
+
+    // Metrics are only served when a port is given but are always recorded,
+    // the cost being a few relaxed atomic adds per chunk.
+    auto registry = metrics::Registry{};
+    auto & sessions = registry.addGauge(
+      "enigma_active_sessions", "Streams currently being encoded.");
+    auto & symbols = registry.addCounter(
+      "enigma_symbols_encoded_total", "Symbols enciphered.");
+    auto & bytes = registry.addCounter(
+      "enigma_bytes_total", "Bytes processed, symbols or not.");
+    auto & latency = registry.addHistogram(
+      "enigma_chunk_encode_seconds", "Time to encode one chunk.");
+
+#if defined(ENIGMA_METRICS_HAS_SOCKETS)
+    auto server = std::unique_ptr<metrics::Server>{};
+    if (metrics_port != 0ul) {
+      server = std::make_unique<metrics::Server>(
+        registry, static_cast<std::uint16_t>(metrics_port));
+      if (!server->isListening()) {
+        std::cerr << "enigma stream: cannot listen on port " << metrics_port
+                  << "\n";
+        return 1;
+      }
+    }
+#endif
+
+    auto on_chunk = [&](ChunkStats const & stats) {
+      symbols.add(stats.symbols);
+      bytes.add(stats.bytes);
+      latency.observe(stats.encode_seconds);
+    };
+
+    auto machine = makeMachine();
+    machine.advance(offset);
+
+    // Runs `encoder` over standard input, deciphering if asked.
+    auto run = [&](auto & encoder, auto const & alphabet) {
+#if defined(ENIGMA_PIPE_SPLICE)
+      if (pipe) {
+        encodePipe(encoder, STDIN_FILENO, STDOUT_FILENO, on_chunk, alphabet);
+        return;
+      }
+#endif
+      encodeStream(encoder, std::cin, std::cout, chunk_size, on_chunk,
+                   alphabet);
+    };
+    auto transcode = [&](auto & encoder, auto const & alphabet) {
+      if (decode) {
+        auto decoder = Decoder(encoder);
+        run(decoder, alphabet);
+      } else {
+        run(encoder, alphabet);
+      }
+    };
+
+    // The session ends however encoding does.
+    struct SessionScope {
+      metrics::Gauge & gauge;
+
+      ~SessionScope() {
+        gauge.add(-1);
+      }
+    };
+
+    std::ios::sync_with_stdio(false);
+    sessions.add(1);
+    auto session = SessionScope{sessions};
+    try {
+      if (spec) {
+        auto spec_machine = spec::Machine{*spec};
+        spec_machine.advance(offset);
+        transcode(spec_machine, spec_machine.getAlphabet());
+      } else if (precompute) {
+        auto keystream = Keystream(machine);
+        run(keystream, LatinAlphabet{});
+      } else if (pipe) {
+        auto composite = CompositeMachine(machine);
+        transcode(composite, LatinAlphabet{});
+      } else {
+        transcode(machine, LatinAlphabet{});
+      }
+    } catch (std::system_error const & error) {
+      std::cerr << "enigma stream: " << error.what() << "\n";
+      return 1;
+    }
+
+    if (!trace_path.empty()) {
+      auto file = std::ofstream{trace_path};
+      trace::Recorder::getInstance().writeChromeTrace(file);
+      if (!file) {
+        std::cerr << "enigma stream: failed to write '" << trace_path << "'\n";
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  // runFiles --
+  // Enciphers files and directory trees into an output directory in
+  // parallel, reporting progress on standard error.
+  // Usage: enigma files --output DIR [--key N] [--threads N]
+  //                     [--split BYTES] [--batch BYTES] [--decode] PATH...
+  //
+  // Each file gets its own machine, derived from the master key (`--key`)
+  // and the file's path relative to the output directory (see
+  // `files::deriveMachine`). A directory is written under its own name in
+  // the output directory, so `--decode` of that copy, with the same key,
+  // recovers the original tree. Files above `--split` bytes are enciphered
+  // in ranges by several threads; files below `--batch` bytes are grouped
+  // into jobs of about that size.
+  //
+  int runFiles(std::vector<std::string> const & args) {
+    using Clock = std::chrono::steady_clock;
+
+    auto options = files::Options{};
+    auto output = std::filesystem::path{};
+    auto roots = std::vector<std::filesystem::path>{};
+    auto master = std::uint64_t{0u};
+
+    for (auto i = 0u; i < args.size(); ++i) {
+      auto has_value = i + 1u < args.size();
+      if (args[i] == "--output" && has_value) {
+        output = args[++i];
+      } else if (args[i] == "--key" && has_value) {
+        master = std::strtoull(args[++i].c_str(), nullptr, 10);
+      } else if (args[i] == "--threads" && has_value) {
+        options.threads = std::strtoull(args[++i].c_str(), nullptr, 10);
+      } else if (args[i] == "--split" && has_value) {
+        options.split_size = std::strtoull(args[++i].c_str(), nullptr, 10);
+      } else if (args[i] == "--batch" && has_value) {
+        options.batch_size = std::strtoull(args[++i].c_str(), nullptr, 10);
+      } else if (args[i] == "--decode") {
+        options.decode = true;
+      } else if (args[i].rfind("--", 0u) == 0u) {
+        std::cerr << "enigma files: unknown option '" << args[i] << "'\n";
+        return 1;
+      } else {
+        roots.emplace_back(args[i]);
+      }
+    }
+
+    if (output.empty() || roots.empty()) {
+      std::cerr << "enigma files: --output and at least one path required\n";
+      return 1;
+    }
+    if (options.split_size == 0u) {
+      std::cerr << "enigma files: split size must be non-zero\n";
+      return 1;
+    }
+
+    auto tasks = std::vector<files::FileTask>{};
+    try {
+      tasks = files::collectTasks(roots, output);
+    } catch (std::filesystem::filesystem_error const & error) {
+      std::cerr << "enigma files: " << error.what() << "\n";
+      return 1;
+    } catch (std::invalid_argument const & error) {
+      std::cerr << "enigma files: " << error.what() << "\n";
+      return 1;
+    }
+    auto jobs = files::planJobs(tasks, options);
+    auto total = std::uint64_t{0u};
+    for (auto const & task : tasks) {
+      total += task.size;
+    }
+
+    auto progress = files::Progress{};
+    auto begin = Clock::now();
+    auto report = [&](char end) {
+      auto seconds = std::chrono::duration<double>(Clock::now() - begin);
+      auto megabytes = progress.bytes.load() / 1048576.0;
+      std::cerr << "\r" << progress.files.load() << "/" << tasks.size()
+                << " files, " << std::fixed << std::setprecision(1)
+                << megabytes << "/" << total / 1048576.0 << " MiB, "
+                << megabytes / std::max(seconds.count(), 1e-9) << " MiB/s"
+                << end << std::flush;
+    };
+
+    // Progress is printed every half second until the encoder finishes.
+    auto mutex = std::mutex{};
+    auto finished = std::condition_variable{};
+    auto done = false;
+    auto reporter = std::thread{[&] {
+      auto lock = std::unique_lock{mutex};
+      while (!finished.wait_for(lock, std::chrono::milliseconds{500},
+                                [&] { return done; })) {
+        report(' ');
+      }
+    }};
+
+    auto encoder = files::FileEncoder{makeMachine(), master, options};
+    auto errors = encoder.run(tasks, jobs, progress);
+    {
+      auto lock = std::lock_guard{mutex};
+      done = true;
+    }
+    finished.notify_one();
+    reporter.join();
+    report('\n');
+
+    for (auto const & error : errors) {
+      std::cerr << "enigma files: " << error << "\n";
+    }
+    return errors.empty() ? 0 : 1;
+  }
+
+}
+
+// -----------------------------------------------------------------------------
+
+int main(int argc, char ** argv) {
+
+  auto args = std::vector<std::string>(argv + std::min(argc, 2), argv + argc);
+
+  if (argc > 1 && std::string{argv[1]} == "stream") {
+    return runStream(args);
+  }
+
+  if (argc > 1 && std::string{argv[1]} == "files") {
+    return runFiles(args);
+  }
+
+  return runShuffle();
 }
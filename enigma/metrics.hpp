@@ -0,0 +1,375 @@
+#ifndef ENIGMA_METRICS_HPP
+#define ENIGMA_METRICS_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <sstream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <array>
+#include <mutex>
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#define ENIGMA_METRICS_HAS_SOCKETS 1
+#endif
+
+namespace enigma::metrics {
+
+  // Counter shards ------------------------------------------------------------
+  // Metrics are split into cache line sized shards. Each thread is assigned a
+  // shard on first use, so concurrent writers rarely share a line and writes
+  // are a single relaxed `fetch_add`. Readers sum the shards without locking;
+  // a scrape therefore never blocks a writer, it may only miss increments
+  // which happen during the scrape.
+  //
+
+  inline constexpr std::size_t shard_count = 16u;
+  inline constexpr std::size_t cache_line = 64u;
+
+  inline std::size_t getShardIndex() {
+    static auto next = std::atomic<std::size_t>{0u};
+    thread_local auto index =
+      next.fetch_add(1u, std::memory_order_relaxed) % shard_count;
+    return index;
+  }
+
+  struct alignas(cache_line) Shard {
+    std::atomic<std::uint64_t> value = 0u;
+  };
+
+  // Counter class -------------------------------------------------------------
+  // Monotonically increasing total.
+  //
+  class Counter {
+  public:
+
+    void add(std::uint64_t value = 1u) {
+      shards[getShardIndex()].value.fetch_add(value,
+                                              std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::uint64_t get() const {
+      auto total = std::uint64_t{0u};
+      for (auto const & shard : shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+      }
+      return total;
+    }
+
+  private:
+
+    std::array<Shard, shard_count> shards;
+  };
+
+  // Gauge class ---------------------------------------------------------------
+  // Value which may go up and down (e.g. active sessions, queue depth).
+  // Gauges are typically written by few threads so are not sharded.
+  //
+  class Gauge {
+  public:
+
+    void add(std::int64_t value = 1) {
+      this->value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void set(std::int64_t value) {
+      this->value.store(value, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::int64_t get() const {
+      return value.load(std::memory_order_relaxed);
+    }
+
+  private:
+
+    alignas(cache_line) std::atomic<std::int64_t> value = 0;
+  };
+
+  // Histogram class -----------------------------------------------------------
+  // Distribution of observed values (e.g. latencies in seconds) over fixed,
+  // ascending upper bounds. Bucket counts are stored per shard and made
+  // cumulative on scrape, as the Prometheus exposition format requires.
+  //
+  class Histogram {
+  public:
+
+    explicit Histogram(std::vector<double> bounds):
+        bounds(std::move(bounds)),
+        shards(new ShardData[shard_count]) {
+      std::sort(this->bounds.begin(), this->bounds.end());
+      for (auto i = 0u; i < shard_count; ++i) {
+        shards[i].buckets =
+          std::make_unique<std::atomic<std::uint64_t>[]>(
+            this->bounds.size() + 1u);
+      }
+    }
+
+    // getLatencyBounds --
+    // Exponential bounds from 1 microsecond to roughly 1 second.
+    //
+    static std::vector<double> getLatencyBounds() {
+      auto bounds = std::vector<double>{};
+      for (auto bound = 1e-6; bound < 2.0; bound *= 4.0) {
+        bounds.push_back(bound);
+      }
+      return bounds;
+    }
+
+    void observe(double value) {
+      auto bucket = std::lower_bound(bounds.begin(), bounds.end(), value) -
+                    bounds.begin();
+      auto & shard = shards[getShardIndex()];
+      shard.buckets[bucket].fetch_add(1u, std::memory_order_relaxed);
+
+      // Single writer per shard in the common case; a CAS loop keeps the sum
+      // correct when threads share a shard.
+      auto sum = shard.sum.load(std::memory_order_relaxed);
+      while (!shard.sum.compare_exchange_weak(sum, sum + value,
+                                              std::memory_order_relaxed)) {}
+    }
+
+    [[nodiscard]] std::vector<double> const & getBounds() const {
+      return bounds;
+    }
+
+    // getBuckets --
+    // Returns the cumulative count for each bound, followed by the total.
+    //
+    [[nodiscard]] std::vector<std::uint64_t> getBuckets() const {
+      auto counts = std::vector<std::uint64_t>(bounds.size() + 1u, 0u);
+      for (auto i = 0u; i < shard_count; ++i) {
+        for (auto j = 0u; j < counts.size(); ++j) {
+          counts[j] += shards[i].buckets[j].load(std::memory_order_relaxed);
+        }
+      }
+      std::partial_sum(counts.begin(), counts.end(), counts.begin());
+      return counts;
+    }
+
+    [[nodiscard]] double getSum() const {
+      auto sum = 0.0;
+      for (auto i = 0u; i < shard_count; ++i) {
+        sum += shards[i].sum.load(std::memory_order_relaxed);
+      }
+      return sum;
+    }
+
+  private:
+
+    struct alignas(cache_line) ShardData {
+      std::unique_ptr<std::atomic<std::uint64_t>[]> buckets;
+      std::atomic<double> sum = 0.0;
+    };
+
+    std::vector<double> bounds;
+    std::unique_ptr<ShardData[]> shards;
+  };
+
+  // Registry class ------------------------------------------------------------
+  // Owns named metrics and renders them in the Prometheus text format.
+  // Registration takes a lock and is expected at start-up only; the returned
+  // references stay valid for the lifetime of the registry.
+  //
+  class Registry {
+  public:
+
+    Counter & addCounter(std::string name, std::string help) {
+      return add<Counter>(counters, std::move(name), std::move(help));
+    }
+
+    Gauge & addGauge(std::string name, std::string help) {
+      return add<Gauge>(gauges, std::move(name), std::move(help));
+    }
+
+    Histogram & addHistogram(std::string name, std::string help,
+                             std::vector<double> bounds =
+                               Histogram::getLatencyBounds()) {
+      return add<Histogram>(histograms, std::move(name), std::move(help),
+                            std::move(bounds));
+    }
+
+    // writePrometheus --
+    // Writes every metric in text exposition format version 0.0.4.
+    //
+    void writePrometheus(std::ostream & os) const {
+      auto lock = std::lock_guard{mutex};
+
+      for (auto const & entry : counters) {
+        writeHeader(os, entry, "counter");
+        os << entry.name << " " << entry.metric->get() << "\n";
+      }
+
+      for (auto const & entry : gauges) {
+        writeHeader(os, entry, "gauge");
+        os << entry.name << " " << entry.metric->get() << "\n";
+      }
+
+      for (auto const & entry : histograms) {
+        writeHeader(os, entry, "histogram");
+        auto const & bounds = entry.metric->getBounds();
+        auto buckets = entry.metric->getBuckets();
+        for (auto i = 0u; i < bounds.size(); ++i) {
+          os << entry.name << "_bucket{le=\"" << bounds[i] << "\"} "
+             << buckets[i] << "\n";
+        }
+        os << entry.name << "_bucket{le=\"+Inf\"} " << buckets.back() << "\n"
+           << entry.name << "_sum " << entry.metric->getSum() << "\n"
+           << entry.name << "_count " << buckets.back() << "\n";
+      }
+    }
+
+  private:
+
+    template<class MetricT>
+    struct Entry {
+      std::string name;
+      std::string help;
+      std::unique_ptr<MetricT> metric;
+    };
+
+    template<class MetricT, class ... Args>
+    MetricT & add(std::vector<Entry<MetricT>> & entries, std::string name,
+                  std::string help, Args && ... args) {
+      auto lock = std::lock_guard{mutex};
+      auto metric = std::make_unique<MetricT>(std::forward<Args>(args)...);
+      auto & result = *metric;
+      entries.push_back({std::move(name), std::move(help), std::move(metric)});
+      return result;
+    }
+
+    template<class EntryT>
+    static void writeHeader(std::ostream & os, EntryT const & entry,
+                            char const * type) {
+      os << "# HELP " << entry.name << " " << entry.help << "\n"
+         << "# TYPE " << entry.name << " " << type << "\n";
+    }
+
+    mutable std::mutex mutex;
+    std::vector<Entry<Counter>> counters;
+    std::vector<Entry<Gauge>> gauges;
+    std::vector<Entry<Histogram>> histograms;
+  };
+
+#if defined(ENIGMA_METRICS_HAS_SOCKETS)
+
+  // Server class --------------------------------------------------------------
+  // Minimal HTTP/1.0 endpoint serving a `Registry` on the loopback interface.
+  // Every request, whatever its path, receives the current exposition. Runs on
+  // its own thread so scrapes never execute on an encoding thread.
+  //
+  class Server {
+  public:
+
+    Server(Registry const & registry, std::uint16_t port):
+        registry(registry) {
+      socket_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+      if (socket_fd < 0) {
+        return;
+      }
+
+      auto enable = 1;
+      ::setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &enable,
+                   sizeof(enable));
+
+      auto address = sockaddr_in{};
+      address.sin_family = AF_INET;
+      address.sin_port = htons(port);
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+      auto bound = ::bind(socket_fd, reinterpret_cast<sockaddr *>(&address),
+                          sizeof(address)) == 0;
+      if (!bound || ::listen(socket_fd, 8) != 0) {
+        ::close(socket_fd);
+        socket_fd = -1;
+        return;
+      }
+
+      thread = std::thread([this] { serve(); });
+    }
+
+    Server(Server const &) = delete;
+    Server & operator=(Server const &) = delete;
+
+    ~Server() {
+      running.store(false, std::memory_order_relaxed);
+      if (thread.joinable()) {
+        thread.join();
+      }
+      if (socket_fd >= 0) {
+        ::close(socket_fd);
+      }
+    }
+
+    [[nodiscard]] bool isListening() const {
+      return socket_fd >= 0;
+    }
+
+  private:
+
+    void serve() {
+      auto descriptor = pollfd{socket_fd, POLLIN, 0};
+      while (running.load(std::memory_order_relaxed)) {
+        if (::poll(&descriptor, 1, 100) <= 0) {
+          continue;
+        }
+
+        auto client = ::accept(socket_fd, nullptr, nullptr);
+        if (client < 0) {
+          continue;
+        }
+
+        // The request itself is ignored but must be drained before replying.
+        char request[1024];
+        auto client_descriptor = pollfd{client, POLLIN, 0};
+        if (::poll(&client_descriptor, 1, 100) > 0) {
+          (void)::recv(client, request, sizeof(request), 0);
+        }
+
+        auto body = std::ostringstream{};
+        registry.writePrometheus(body);
+        auto content = body.str();
+
+        auto response = std::ostringstream{};
+        response << "HTTP/1.0 200 OK\r\n"
+                 << "Content-Type: text/plain; version=0.0.4\r\n"
+                 << "Content-Length: " << content.size() << "\r\n\r\n"
+                 << content;
+        auto text = response.str();
+
+        for (auto sent = std::size_t{0u}; sent < text.size();) {
+          auto result = ::send(client, text.data() + sent, text.size() - sent,
+                               MSG_NOSIGNAL);
+          if (result <= 0) {
+            break;
+          }
+          sent += static_cast<std::size_t>(result);
+        }
+        ::close(client);
+      }
+    }
+
+    Registry const & registry;
+    std::atomic<bool> running = true;
+    std::thread thread;
+    int socket_fd = -1;
+  };
+
+#endif
+
+}
+
+#endif // ENIGMA_METRICS_HPP
@@ -0,0 +1,392 @@
+#ifndef ENIGMA_MITM_HPP
+#define ENIGMA_MITM_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <stdexcept>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <array>
+#include <mutex>
+
+#include "enigma.hpp"
+
+namespace enigma {
+
+  // MitmOptions struct --------------------------------------------------------
+  // `memory_budget` - Upper bound on table memory, in bytes.
+  // `threads` - Threads used to build the table and search; 0 for one per
+  //             hardware thread.
+  //
+  struct MitmOptions {
+    std::size_t memory_budget = std::size_t{256u} << 20u;
+    unsigned threads = 0u;
+  };
+
+  // MitmSearch class ----------------------------------------------------------
+  // Known-plaintext search for the starting rotor positions of a machine with
+  // known wiring, meeting in the middle of the rotor assembly.
+  //
+  // The rotors are split into `inner_count` inner rotors (from the first) and
+  // the outer rotors. For every position of the outer rotors, the composite
+  // of the outer rotors and reflector is tabulated once. Each entry of the
+  // composite is a pair `(u, C(u))`; every tuple of `key_length` such pairs
+  // is hashed into an open-addressing table, pointing back to the outer
+  // positions. The key length is the largest the memory budget allows, up
+  // to 3.
+  //
+  // Each candidate position of the inner rotors is then run over the crib:
+  // the value entering the outer rotors (`u`) is found forward from the
+  // plaintext, and the value leaving them (`v`) backward from the
+  // ciphertext. While no carry reaches the outer rotors their composite is
+  // fixed, so the first `key_length` pairs `(u, v)` form a key whose matches
+  // in the table are the only outer positions consistent with them. Matches
+  // are verified against the whole crib. Candidates whose inner rotors carry
+  // within the key span are checked against every outer position.
+  //
+  // Work falls from `base^rotor_count` full machine runs to roughly
+  // `base^inner_count` probes, plus a table of
+  // `base^(rotor_count - inner_count + key_length)` entries.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class MitmSearch {
+  public:
+
+    static_assert(base <= 256u);
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using PositionArray = typename MachineType::PositionArray;
+    using Index = IndexT;
+
+    static constexpr std::size_t max_key_length = 3u;
+
+    MitmSearch() = delete;
+
+    // Constructor --
+    // `machine` - Supplies the wiring, notches and reflector. Its positions
+    //             are ignored.
+    // `inner_count` - Number of inner rotors, at least 1 and fewer than
+    //                 `rotor_count`.
+    //
+    // Throws `std::invalid_argument` if `inner_count` is out of range, or if
+    // the table for even a key length of 1 exceeds the memory budget.
+    //
+    MitmSearch(MachineType const & machine, std::size_t inner_count,
+               MitmOptions const & options = {}):
+        machine(machine),
+        inner_count(inner_count),
+        threads(options.threads) {
+
+      if (threads == 0u) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+      if (inner_count == 0u || inner_count >= rotor_count) {
+        throw std::invalid_argument(
+          "inner_count must be at least 1 and less than rotor_count");
+      }
+
+      inner_states = power(inner_count);
+      outer_states = power(rotor_count - inner_count);
+      if (outer_states > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("too many outer rotor positions");
+      }
+
+      for (key_length = max_key_length; key_length > 1u; --key_length) {
+        if (getTableBytes(key_length) <= options.memory_budget) {
+          break;
+        }
+      }
+      if (getTableBytes(key_length) > options.memory_budget) {
+        throw std::invalid_argument("memory budget too small for the table");
+      }
+
+      build();
+    }
+
+    [[nodiscard]] std::size_t getKeyLength() const {
+      return key_length;
+    }
+
+    [[nodiscard]] std::size_t getTableSize() const {
+      return slot_count;
+    }
+
+    // search --
+    // Returns every starting position (before the first advance) under which
+    // the machine enciphers `plain` to `cipher`, in ascending order.
+    //
+    [[nodiscard]] std::vector<PositionArray>
+    search(std::vector<Index> const & plain,
+           std::vector<Index> const & cipher) const {
+      assert(plain.size() == cipher.size());
+
+      auto results = std::vector<PositionArray>{};
+      auto mutex = std::mutex{};
+      auto next = std::atomic<std::size_t>{0u};
+
+      auto worker = [&] {
+        auto found = std::vector<PositionArray>{};
+        auto verifier = machine;
+        for (auto inner = next++; inner < inner_states; inner = next++) {
+          searchInner(inner, plain, cipher, verifier, found);
+        }
+        auto lock = std::lock_guard{mutex};
+        results.insert(results.end(), found.begin(), found.end());
+      };
+
+      runThreads(worker);
+      std::sort(results.begin(), results.end());
+      return results;
+    }
+
+  private:
+
+    using Key = std::uint64_t;
+
+    static constexpr Key empty_key = ~Key{0u};
+
+    static std::size_t power(std::size_t exponent) {
+      auto result = std::size_t{1u};
+      for (auto i = 0u; i < exponent; ++i) {
+        result *= base;
+      }
+      return result;
+    }
+
+    static std::size_t hash(Key key) {
+      key ^= key >> 33u;
+      key *= 0xFF51AFD7ED558CCDull;
+      key ^= key >> 33u;
+      return static_cast<std::size_t>(key);
+    }
+
+    // getSlotCount --
+    // Slots for `key_length`, a power of two at most half full.
+    //
+    [[nodiscard]] std::size_t getSlotCount(std::size_t length) const {
+      auto entries = outer_states * power(length);
+      auto slots = std::size_t{1u};
+      while (slots < 2u * entries) {
+        slots *= 2u;
+      }
+      return slots;
+    }
+
+    [[nodiscard]] std::size_t getTableBytes(std::size_t length) const {
+      return getSlotCount(length) * (sizeof(Key) + sizeof(std::uint32_t));
+    }
+
+    template<class Func>
+    void runThreads(Func & func) const {
+      auto pool = std::vector<std::thread>{};
+      for (auto i = 1u; i < threads; ++i) {
+        pool.emplace_back(func);
+      }
+      func();
+      for (auto & thread : pool) {
+        thread.join();
+      }
+    }
+
+    // makeKey --
+    // Packs `key_length` pairs, all `u` values first.
+    //
+    [[nodiscard]] Key makeKey(Index const * u, Index const * v) const {
+      auto key = Key{0u};
+      for (auto i = 0u; i < key_length; ++i) {
+        key = (key << 8u) | u[i];
+      }
+      for (auto i = 0u; i < key_length; ++i) {
+        key = (key << 8u) | v[i];
+      }
+      return key;
+    }
+
+    // getOuterPositions --
+    // Writes the positions of outer state `state` into `positions`.
+    //
+    void getOuterPositions(std::size_t state, PositionArray & positions) const {
+      for (auto i = inner_count; i < rotor_count; ++i) {
+        positions[i] = state % base;
+        state /= base;
+      }
+    }
+
+    void build() {
+      slot_count = getSlotCount(key_length);
+      keys = std::make_unique<std::atomic<Key>[]>(slot_count);
+      for (auto i = std::size_t{0u}; i < slot_count; ++i) {
+        keys[i].store(empty_key, std::memory_order_relaxed);
+      }
+      states.resize(slot_count);
+
+      auto next = std::atomic<std::size_t>{0u};
+      auto worker = [&] {
+        for (auto state = next++; state < outer_states; state = next++) {
+          buildState(state);
+        }
+      };
+      runThreads(worker);
+    }
+
+    void buildState(std::size_t state) {
+      auto const & rotors = machine.getRotors();
+      auto positions = PositionArray{};
+      getOuterPositions(state, positions);
+
+      auto composite = std::array<Index, base>{};
+      for (auto val = 0u; val < base; ++val) {
+        auto out = static_cast<Index>(val);
+        for (auto i = inner_count; i < rotor_count; ++i) {
+          auto const & forward = rotors[i].getForwardCipher();
+          out = forward[(positions[i] + out) % base];
+        }
+        out = machine.getReflector()[out];
+        for (auto i = rotor_count; i-- > inner_count;) {
+          auto const & reverse = rotors[i].getReverseCipher();
+          out = reverse[(positions[i] + out) % base];
+        }
+        composite[val] = out;
+      }
+
+      // Every tuple of inputs, with its outputs.
+      auto u = std::array<Index, max_key_length>{};
+      auto v = std::array<Index, max_key_length>{};
+      auto const tuples = power(key_length);
+      for (auto tuple = std::size_t{0u}; tuple < tuples; ++tuple) {
+        auto rest = tuple;
+        for (auto i = 0u; i < key_length; ++i) {
+          u[i] = static_cast<Index>(rest % base);
+          v[i] = composite[u[i]];
+          rest /= base;
+        }
+        insert(makeKey(u.data(), v.data()), state);
+      }
+    }
+
+    void insert(Key key, std::size_t state) {
+      auto const mask = slot_count - 1u;
+      for (auto slot = hash(key) & mask;; slot = (slot + 1u) & mask) {
+        auto expected = empty_key;
+        if (keys[slot].compare_exchange_strong(expected, key,
+                                               std::memory_order_relaxed)) {
+          states[slot] = static_cast<std::uint32_t>(state);
+          return;
+        }
+      }
+    }
+
+    // searchInner --
+    // Runs inner state `inner` over the crib and verifies every outer state
+    // it could meet, appending matches to `found`.
+    //
+    void searchInner(std::size_t inner, std::vector<Index> const & plain,
+                     std::vector<Index> const & cipher, MachineType & verifier,
+                     std::vector<PositionArray> & found) const {
+      auto const & rotors = machine.getRotors();
+      auto start = PositionArray{};
+      for (auto i = 0u; i < inner_count; ++i) {
+        start[i] = inner % base;
+        inner /= base;
+      }
+
+      // Values entering and leaving the outer rotors, while none carries.
+      auto u = std::array<Index, max_key_length>{};
+      auto v = std::array<Index, max_key_length>{};
+      auto positions = start;
+      auto span = std::size_t{0u};
+      for (; span < key_length && span < plain.size(); ++span) {
+        if (stepInner(positions)) {
+          break;
+        }
+
+        auto in = plain[span];
+        for (auto i = 0u; i < inner_count; ++i) {
+          in = rotors[i].getForwardCipher()[(positions[i] + in) % base];
+        }
+        auto out = cipher[span];
+        for (auto i = 0u; i < inner_count; ++i) {
+          auto back = rotors[i].getForwardCipher()[out];
+          out = static_cast<Index>((back + base - positions[i]) % base);
+        }
+        u[span] = in;
+        v[span] = out;
+      }
+
+      auto verify = [&](std::size_t state) {
+        auto candidate = start;
+        getOuterPositions(state, candidate);
+        verifier.setPositions(candidate);
+        for (auto i = 0u; i < plain.size(); ++i) {
+          if (verifier.encodeNext(plain[i]) != cipher[i]) {
+            return;
+          }
+        }
+        found.push_back(candidate);
+      };
+
+      if (span < key_length) {
+        for (auto state = std::size_t{0u}; state < outer_states; ++state) {
+          verify(state);
+        }
+        return;
+      }
+
+      auto const key = makeKey(u.data(), v.data());
+      auto const mask = slot_count - 1u;
+      for (auto slot = hash(key) & mask;; slot = (slot + 1u) & mask) {
+        auto stored = keys[slot].load(std::memory_order_relaxed);
+        if (stored == empty_key) {
+          return;
+        }
+        if (stored == key) {
+          verify(states[slot]);
+        }
+      }
+    }
+
+    // stepInner --
+    // Advances the inner rotors of `positions` by one step. Returns true if
+    // the step carries into the outer rotors.
+    //
+    bool stepInner(PositionArray & positions) const {
+      auto const & rotors = machine.getRotors();
+      for (auto level = 0u; level < inner_count; ++level) {
+        if (++positions[level] == base) {
+          positions[level] = 0u;
+        }
+        if (!rotors[level].getNotches()[positions[level]]) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    MachineType machine;
+    std::size_t inner_count;
+    unsigned threads;
+    std::size_t inner_states = 0u;
+    std::size_t outer_states = 0u;
+    std::size_t key_length = 1u;
+    std::size_t slot_count = 0u;
+    std::unique_ptr<std::atomic<Key>[]> keys;
+    std::vector<std::uint32_t> states;
+  };
+
+  // MitmSearch class deduction guides -----------------------------------------
+
+  template<class T, class ... Args> MitmSearch(T const &, Args && ...) ->
+    MitmSearch<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_MITM_HPP
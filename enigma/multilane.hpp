@@ -0,0 +1,266 @@
+#ifndef ENIGMA_MULTILANE_HPP
+#define ENIGMA_MULTILANE_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <type_traits>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+#include "enigma.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ENIGMA_MULTILANE_VBMI 1
+#endif
+
+namespace enigma {
+
+  // MultiLaneGenerator class --------------------------------------------------
+  // Runs `lanes` independent `Generator` streams in lock-step. Every lane
+  // shares the wiring of one machine but has its own rotor positions and
+  // seed; lane `k` produces exactly the values of a `Generator` over a copy
+  // of the machine set to `positions[k]`, seeded with `seeds[k]`.
+  //
+  // Each stream is a serial feedback loop, but the lanes are independent, so
+  // their state is held one array per rotor (structure of arrays) and
+  // all lanes advance together. Rotor tables are doubled so that offsets
+  // never wrap. For bases up to 64 a doubled table fits in two AVX-512
+  // registers, and on CPUs with AVX-512 VBMI every rotor and the reflector
+  // is a single byte permute (`vpermi2b`) over 64 lanes; stepping is a masked
+  // add and compare. Otherwise the same arithmetic runs a lane at a time,
+  // which still overlaps the lanes' independent lookups.
+  //
+  // Output is interleaved: round `i` of `generate` writes lane `k` to
+  // `out[i * lanes + k]`. `operator()` returns the same sequence one value
+  // at a time.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count,
+           std::size_t lanes>
+  class MultiLaneGenerator {
+  public:
+
+    static_assert(lanes > 0u);
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using PositionArray = typename MachineType::PositionArray;
+    using result_type = typename MachineType::Index;
+
+    // Type of each lane's positions and values.
+    using Lane = std::conditional_t<base <= 256u, std::uint8_t,
+                                    std::uint32_t>;
+
+    static constexpr std::size_t getLaneCount() {
+      return lanes;
+    }
+
+    MultiLaneGenerator() = delete;
+
+    // Constructor --
+    // `machine` - Supplies the wiring, notches and reflector. Its positions
+    //             are ignored.
+    // `positions` - Starting rotor positions of each lane.
+    // `seeds` - First feedback value of each lane.
+    //
+    MultiLaneGenerator(MachineType const & machine,
+                       std::array<PositionArray, lanes> const & positions,
+                       std::array<result_type, lanes> const & seeds) {
+      auto const & rotors = machine.getRotors();
+      for (auto r = 0u; r < rotor_count; ++r) {
+        auto const & forward = rotors[r].getForwardCipher();
+        auto const & reverse = rotors[r].getReverseCipher();
+        for (auto i = 0u; i < 2u * base; ++i) {
+          tables[r].forward[i] = forward[i % base];
+          tables[r].reverse[i] = reverse[i % base];
+        }
+        for (auto i = 0u; i < base; ++i) {
+          tables[r].notches[i] = rotors[r].getNotches()[i] ? 1u : 0u;
+        }
+      }
+      for (auto i = 0u; i < base; ++i) {
+        reflector[i] = machine.getReflector()[i];
+      }
+
+      for (auto k = 0u; k < lanes; ++k) {
+        for (auto r = 0u; r < rotor_count; ++r) {
+          assert(positions[k][r] < base);
+          state[r][k] = static_cast<Lane>(positions[k][r]);
+        }
+        assert(seeds[k] < base);
+        values[k] = static_cast<Lane>(seeds[k]);
+      }
+    }
+
+    static constexpr result_type min() {
+      return 0u;
+    }
+
+    static constexpr result_type max() {
+      return base - 1u;
+    }
+
+    // getPositions --
+    // Current rotor positions of lane `k`.
+    //
+    [[nodiscard]] PositionArray getPositions(std::size_t k) const {
+      assert(k < lanes);
+      auto positions = PositionArray{};
+      for (auto r = 0u; r < rotor_count; ++r) {
+        positions[r] = state[r][k];
+      }
+      return positions;
+    }
+
+    result_type operator()() {
+      if (next == lanes) {
+        round();
+        next = 0u;
+      }
+      return static_cast<result_type>(values[next++]);
+    }
+
+    // generate --
+    // Writes `rounds` rounds of output, `rounds * lanes` values, to `out`.
+    // Must not be mixed with a partly consumed `operator()` round.
+    //
+    void generate(result_type * out, std::size_t rounds) {
+      assert(next == lanes);
+      for (auto i = std::size_t{0u}; i < rounds; ++i, out += lanes) {
+        round();
+        for (auto k = 0u; k < lanes; ++k) {
+          out[k] = static_cast<result_type>(values[k]);
+        }
+      }
+    }
+
+  private:
+
+    // Doubled tables, padded to the 128 bytes a byte permute reads.
+    static constexpr std::size_t table_size =
+      2u * base < 128u ? 128u : 2u * base;
+
+    // Lanes rounded up to whole registers. Padding lanes run, unread, so
+    // that no load or store needs a mask.
+    static constexpr std::size_t padded_lanes = (lanes + 63u) / 64u * 64u;
+
+    struct Tables {
+      std::array<Lane, table_size> forward = {};
+      std::array<Lane, table_size> reverse = {};
+      std::array<Lane, table_size> notches = {};
+    };
+
+    // round --
+    // Advances every lane and feeds its last value back through it.
+    //
+    void round() {
+#if defined(ENIGMA_MULTILANE_VBMI)
+      if constexpr (base <= 64u) {
+        if (has_vbmi) {
+          roundVbmi();
+          return;
+        }
+      }
+#endif
+      for (auto k = std::size_t{0u}; k < lanes; ++k) {
+        roundLane(k);
+      }
+    }
+
+    void roundLane(std::size_t k) {
+      auto carry = true;
+      for (auto r = 0u; r < rotor_count && carry; ++r) {
+        auto & position = state[r][k];
+        if (++position == base) {
+          position = 0u;
+        }
+        carry = tables[r].notches[position] != 0u;
+      }
+
+      auto val = values[k];
+      for (auto r = 0u; r < rotor_count; ++r) {
+        val = tables[r].forward[state[r][k] + val];
+      }
+      val = reflector[val];
+      for (auto r = rotor_count; r-- > 0u;) {
+        val = tables[r].reverse[state[r][k] + val];
+      }
+      values[k] = val;
+    }
+
+#if defined(ENIGMA_MULTILANE_VBMI)
+    static inline bool const has_vbmi =
+      __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512vbmi");
+
+    // lookup --
+    // `table[index]` for each of 64 byte lanes, over a 128-byte table.
+    //
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) static __m512i
+    lookup(Lane const * table, __m512i index) {
+      return _mm512_permutex2var_epi8(_mm512_loadu_si512(table), index,
+                                      _mm512_loadu_si512(table + 64u));
+    }
+
+    // roundVbmi --
+    // As `roundLane`, for 64 lanes at a time.
+    //
+    __attribute__((target("avx512f,avx512bw,avx512vbmi"))) void roundVbmi() {
+      auto const limit = _mm512_set1_epi8(static_cast<char>(base));
+      auto const one = _mm512_set1_epi8(1);
+
+      for (auto k = std::size_t{0u}; k < lanes; k += 64u) {
+        __m512i positions[rotor_count];
+        auto carry = ~__mmask64{0u};
+        for (auto r = 0u; r < rotor_count; ++r) {
+          auto position = _mm512_loadu_si512(&state[r][k]);
+          position = _mm512_mask_add_epi8(position, carry, position, one);
+          position = _mm512_mask_mov_epi8(
+            position, _mm512_cmpeq_epi8_mask(position, limit),
+            _mm512_setzero_si512());
+          _mm512_storeu_si512(&state[r][k], position);
+          positions[r] = position;
+
+          if (r + 1u < rotor_count) {
+            auto notch = lookup(tables[r].notches.data(), position);
+            carry &= _mm512_test_epi8_mask(notch, notch);
+          }
+        }
+
+        auto val = _mm512_loadu_si512(&values[k]);
+        for (auto r = 0u; r < rotor_count; ++r) {
+          val = lookup(tables[r].forward.data(),
+                       _mm512_add_epi8(positions[r], val));
+        }
+        val = lookup(reflector.data(), val);
+        for (auto r = rotor_count; r-- > 0u;) {
+          val = lookup(tables[r].reverse.data(),
+                       _mm512_add_epi8(positions[r], val));
+        }
+        _mm512_storeu_si512(&values[k], val);
+      }
+    }
+#endif
+
+    std::array<Tables, rotor_count> tables;
+    std::array<Lane, table_size> reflector = {};
+    std::array<std::array<Lane, padded_lanes>, rotor_count> state = {};
+    std::array<Lane, padded_lanes> values = {};
+    std::size_t next = lanes;
+  };
+
+  // MultiLaneGenerator class deduction guides ---------------------------------
+
+  template<class T, std::size_t lanes>
+  MultiLaneGenerator(T const &,
+                     std::array<typename T::PositionArray, lanes> const &,
+                     std::array<typename T::Index, lanes> const &) ->
+    MultiLaneGenerator<typename T::Index, T::getBase(), T::getRotorCount(),
+                       lanes>;
+
+}
+
+#endif // ENIGMA_MULTILANE_HPP
@@ -0,0 +1,227 @@
+#ifndef ENIGMA_PERF_HPP
+#define ENIGMA_PERF_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace enigma::perf {
+
+  // Event enumeration ---------------------------------------------------------
+  // Hardware events which may be sampled by a `CounterGroup`.
+  //
+  enum class Event : std::size_t {
+    cycles,
+    instructions,
+    l1d_misses,
+    llc_misses,
+    branch_misses,
+    dtlb_misses,
+    count
+  };
+
+  inline constexpr std::size_t event_count =
+    static_cast<std::size_t>(Event::count);
+
+  [[nodiscard]] constexpr char const * getEventName(Event event) {
+    constexpr char const * names[event_count] = {
+      "cycles", "instructions", "L1d-misses", "LLC-misses", "branch-misses",
+      "dTLB-misses"
+    };
+    return names[static_cast<std::size_t>(event)];
+  }
+
+  // Sample class --------------------------------------------------------------
+  // Counter values gathered between a call to `CounterGroup::start` and
+  // `CounterGroup::stop`. Values for unavailable events are absent.
+  //
+  class Sample {
+  public:
+
+    [[nodiscard]] bool has(Event event) const {
+      return available[index(event)];
+    }
+
+    [[nodiscard]] std::uint64_t get(Event event) const {
+      return values[index(event)];
+    }
+
+    void set(Event event, std::uint64_t value) {
+      values[index(event)] = value;
+      available[index(event)] = true;
+    }
+
+  private:
+
+    static constexpr std::size_t index(Event event) {
+      return static_cast<std::size_t>(event);
+    }
+
+    std::array<std::uint64_t, event_count> values = {};
+    std::array<bool, event_count> available = {};
+  };
+
+  // CounterGroup class --------------------------------------------------------
+  // Reads hardware performance counters via `perf_event_open` for the calling
+  // thread. Each event is opened independently so that a PMU lacking one event
+  // (or a kernel forbidding access through `perf_event_paranoid`) disables only
+  // the affected counters. On platforms without `perf_event_open` every event
+  // reports as unavailable and `start`/`stop` do nothing.
+  //
+  // Counts are scaled by enabled/running time to compensate for multiplexing
+  // when more events are requested than the PMU has counters.
+  //
+  class CounterGroup {
+  public:
+
+    CounterGroup() {
+      descriptors.fill(-1);
+#if defined(__linux__)
+      for (auto i = 0u; i < event_count; ++i) {
+        descriptors[i] = open(static_cast<Event>(i));
+      }
+#endif
+    }
+
+    CounterGroup(CounterGroup const &) = delete;
+    CounterGroup & operator=(CounterGroup const &) = delete;
+
+    ~CounterGroup() {
+#if defined(__linux__)
+      for (auto fd : descriptors) {
+        if (fd >= 0) {
+          ::close(fd);
+        }
+      }
+#endif
+    }
+
+    [[nodiscard]] bool isAvailable(Event event) const {
+      return descriptors[static_cast<std::size_t>(event)] >= 0;
+    }
+
+    // isEnabled --
+    // Returns true if at least one event could be opened.
+    //
+    [[nodiscard]] bool isEnabled() const {
+      for (auto fd : descriptors) {
+        if (fd >= 0) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void start() {
+#if defined(__linux__)
+      for (auto fd : descriptors) {
+        if (fd >= 0) {
+          ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+          ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+      }
+#endif
+    }
+
+    [[nodiscard]] Sample stop() {
+      auto sample = Sample{};
+#if defined(__linux__)
+      for (auto fd : descriptors) {
+        if (fd >= 0) {
+          ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+      }
+
+      for (auto i = 0u; i < event_count; ++i) {
+        auto fd = descriptors[i];
+        if (fd < 0) {
+          continue;
+        }
+
+        // Layout selected by `PERF_FORMAT_TOTAL_TIME_*` in `open`.
+        std::uint64_t data[3] = {};
+        if (::read(fd, data, sizeof(data)) != sizeof(data)) {
+          continue;
+        }
+
+        auto [value, enabled, running] = data;
+        if (running > 0u && running < enabled) {
+          value = static_cast<std::uint64_t>(
+            static_cast<double>(value) * enabled / running);
+        }
+        sample.set(static_cast<Event>(i), value);
+      }
+#endif
+      return sample;
+    }
+
+  private:
+
+#if defined(__linux__)
+    static int open(Event event) {
+      auto attr = perf_event_attr{};
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      auto cache_miss = [](std::uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8u) |
+               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u);
+      };
+
+      switch (event) {
+        case Event::cycles:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_CPU_CYCLES;
+          break;
+        case Event::instructions:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+          break;
+        case Event::l1d_misses:
+          attr.type = PERF_TYPE_HW_CACHE;
+          attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+          break;
+        case Event::llc_misses:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_CACHE_MISSES;
+          break;
+        case Event::branch_misses:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+          break;
+        case Event::dtlb_misses:
+          attr.type = PERF_TYPE_HW_CACHE;
+          attr.config = cache_miss(PERF_COUNT_HW_CACHE_DTLB);
+          break;
+        default:
+          return -1;
+      }
+
+      auto fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0ul);
+      return static_cast<int>(fd);
+    }
+#endif
+
+    std::array<int, event_count> descriptors;
+  };
+
+}
+
+#endif // ENIGMA_PERF_HPP
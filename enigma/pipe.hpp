@@ -0,0 +1,256 @@
+#ifndef ENIGMA_PIPE_HPP
+#define ENIGMA_PIPE_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <system_error>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <cerrno>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#define ENIGMA_PIPE_SPLICE 1
+#endif
+
+#include "stream.hpp"
+
+namespace enigma {
+
+  // encodeBytes --
+  // Enciphers `size` bytes at `bytes` in place, as `encodeStream` does: the
+  // machine advances once per byte and only symbols are substituted.
+  // Returns the number of symbols.
+  //
+  template<class MachineT, class AlphabetT = LatinAlphabet>
+  std::size_t encodeBytes(MachineT & machine, char * bytes, std::size_t size,
+                          AlphabetT const & alphabet = {}) {
+    auto symbols = std::size_t{0u};
+    for (auto i = std::size_t{0u}; i < size; ++i) {
+      auto original = static_cast<unsigned char>(bytes[i]);
+      auto index = alphabet.toIndex(original);
+      if (index != AlphabetT::none) {
+        index = machine.encodeNext(index);
+        bytes[i] = static_cast<char>(alphabet.toChar(index, original));
+        ++symbols;
+      } else {
+        machine.advance();
+      }
+    }
+    return symbols;
+  }
+
+#if defined(ENIGMA_PIPE_SPLICE)
+
+  // Pipe mode -----------------------------------------------------------------
+  // A stdin to stdout path for shell pipelines which avoids the copy into
+  // the output pipe. Both pipes are enlarged (`F_SETPIPE_SZ`). Input is read
+  // into freshly mapped pages, enciphered in place and gifted to the output
+  // pipe with `vmsplice`, which hands the pages themselves to the pipe
+  // rather than copying them. The next chunk is read and enciphered into new
+  // pages while the reader drains the last.
+  //
+  // A spliced page must never change, however long the pipe, or a reader
+  // which `splice`s it onwards, holds it. Pages are therefore written only
+  // before they are spliced and then unmapped, never reused: the pipe keeps
+  // its own reference to each page, so unmapping does not free it under the
+  // reader. Output that is not a pipe is written with `write` from one
+  // reused buffer.
+  //
+
+  inline constexpr std::size_t pipe_buffer_size = 1u << 18u;
+
+  // PipeStats struct --
+  // `pipe_size` is the output pipe's capacity, or zero if it is not a pipe.
+  //
+  struct PipeStats {
+    std::uint64_t bytes;
+    std::size_t pipe_size;
+    bool spliced;
+  };
+
+  namespace detail {
+
+    struct UnmapDeleter {
+      std::size_t size;
+
+      void operator()(char * pages) const {
+        ::munmap(pages, size);
+      }
+    };
+
+    using PageBuffer = std::unique_ptr<char[], UnmapDeleter>;
+
+    // mapPages --
+    // Maps `size` bytes of new anonymous pages.
+    //
+    inline PageBuffer mapPages(std::size_t size) {
+      auto * pages = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (pages == MAP_FAILED) {
+        throw std::bad_alloc{};
+      }
+      return PageBuffer{static_cast<char *>(pages), UnmapDeleter{size}};
+    }
+
+    [[noreturn]] inline void throwErrno(char const * what) {
+      throw std::system_error{errno, std::generic_category(), what};
+    }
+
+    inline bool isPipe(int fd) {
+      struct stat info = {};
+      return ::fstat(fd, &info) == 0 && S_ISFIFO(info.st_mode);
+    }
+
+    // enlargePipe --
+    // Sets the capacity of pipe `fd` to `size`, or the largest power of two
+    // below it which is allowed. Returns the capacity, or zero if `fd` is
+    // not a pipe.
+    //
+    inline std::size_t enlargePipe(int fd, std::size_t size) {
+      if (!isPipe(fd)) {
+        return 0u;
+      }
+      for (; size >= (64u << 10u); size /= 2u) {
+        if (::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(size)) >= 0) {
+          break;
+        }
+      }
+      auto capacity = ::fcntl(fd, F_GETPIPE_SZ);
+      return capacity > 0 ? static_cast<std::size_t>(capacity) : 0u;
+    }
+
+    // readFull --
+    // Reads until `size` bytes or end of input. Returns the bytes read.
+    //
+    inline std::size_t readFull(int fd, char * bytes, std::size_t size) {
+      auto total = std::size_t{0u};
+      while (total < size) {
+        auto count = ::read(fd, bytes + total, size - total);
+        if (count == 0) {
+          break;
+        }
+        if (count < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throwErrno("read");
+        }
+        total += static_cast<std::size_t>(count);
+      }
+      return total;
+    }
+
+    inline void writeFull(int fd, char const * bytes, std::size_t size) {
+      while (size > 0u) {
+        auto count = ::write(fd, bytes, size);
+        if (count < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throwErrno("write");
+        }
+        bytes += count;
+        size -= static_cast<std::size_t>(count);
+      }
+    }
+
+    // spliceFull --
+    // Gifts the pages holding `size` bytes at `bytes` to pipe `fd`. They
+    // must not be written again.
+    //
+    inline void spliceFull(int fd, char * bytes, std::size_t size) {
+      auto iov = iovec{bytes, size};
+      while (iov.iov_len > 0u) {
+        auto count = ::vmsplice(fd, &iov, 1u, SPLICE_F_GIFT);
+        if (count < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throwErrno("vmsplice");
+        }
+        iov.iov_base = static_cast<char *>(iov.iov_base) + count;
+        iov.iov_len -= static_cast<std::size_t>(count);
+      }
+    }
+
+  }
+
+  // encodePipe --
+  // Enciphers `in_fd` to exhaustion into `out_fd` as described above.
+  // `on_chunk`, if set, is invoked after each buffer is handed on. Throws
+  // `std::system_error` on a read or write error.
+  //
+  template<class MachineT, class AlphabetT = LatinAlphabet>
+  PipeStats encodePipe(MachineT & machine, int in_fd, int out_fd,
+                       ChunkFunc const & on_chunk = {},
+                       AlphabetT const & alphabet = {}) {
+    using Clock = std::chrono::steady_clock;
+
+    detail::enlargePipe(in_fd, pipe_buffer_size);
+    auto pipe_size = detail::enlargePipe(out_fd, pipe_buffer_size);
+    auto const size = pipe_buffer_size;
+
+    auto stats = PipeStats{0u, pipe_size, pipe_size > 0u};
+    auto buffer = detail::mapPages(size);
+    for (auto chunk = std::uint64_t{0u};; ++chunk) {
+      // The pages of a spliced chunk now belong to the pipe.
+      if (stats.spliced && chunk > 0u) {
+        buffer = detail::mapPages(size);
+      }
+      auto * bytes = buffer.get();
+      auto count = std::size_t{0u};
+      {
+        auto scope = trace::Scope{"read", chunk};
+        count = detail::readFull(in_fd, bytes, size);
+      }
+
+      if (count == 0u) {
+        break;
+      }
+
+      auto symbols = std::size_t{0u};
+      auto begin = Clock::now();
+      {
+        auto scope = trace::Scope{"encode", chunk};
+        symbols = encodeBytes(machine, bytes, count, alphabet);
+      }
+      auto seconds = std::chrono::duration<double>(Clock::now() - begin);
+
+      {
+        auto scope = trace::Scope{"write", chunk};
+        if (stats.spliced) {
+          detail::spliceFull(out_fd, bytes, count);
+        } else {
+          detail::writeFull(out_fd, bytes, count);
+        }
+      }
+
+      stats.bytes += count;
+      if (on_chunk) {
+        on_chunk({chunk, count, symbols, seconds.count()});
+      }
+
+      // A short read is the end of input.
+      if (count < size) {
+        break;
+      }
+    }
+    return stats;
+  }
+
+#endif
+
+}
+
+#endif // ENIGMA_PIPE_HPP
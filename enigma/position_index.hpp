@@ -0,0 +1,484 @@
+#ifndef ENIGMA_POSITION_INDEX_HPP
+#define ENIGMA_POSITION_INDEX_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <stdexcept>
+#include <algorithm>
+#include <optional>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <array>
+
+#include "enigma.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ENIGMA_POSITION_INDEX_AVX2 1
+#endif
+
+#if defined(__unix__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define ENIGMA_POSITION_INDEX_MMAP 1
+#endif
+
+namespace enigma {
+
+  // PositionIndex class -------------------------------------------------------
+  // Inverted index over the period of a machine: for every pair of
+  // plaintext and ciphertext values `(x, y)`, a bitmap with bit `t` set if
+  // the machine enciphers `x` to `y` at step `t` of its cycle. The cycle is
+  // followed from the positions of the machine given to the constructor.
+  //
+  // A crib `(x_i, y_i)` starting at step `t` (enciphering its first value at
+  // step `t + 1`) is consistent only if bit `t + i + 1` is set in bitmap
+  // `(x_i, y_i)` for every `i`. Shifting each bitmap by `i + 1` and AND-ing
+  // them yields every candidate start at once, 64 (or with AVX2, 256) steps
+  // per operation. Bitmaps repeat their first `max_crib` bits past the end of
+  // the period, so shifts never wrap. Longer cribs are intersected over their
+  // first `max_crib - 1` values and verified against the rest.
+  //
+  // Only positions on the cycle are indexed. With one notch per rotor the
+  // cycle visits every position (see `isComplete`).
+  //
+  // The index is one contiguous block, which `save` writes to disk as is and
+  // `load` maps back into memory (in host byte order).
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class PositionIndex {
+  public:
+
+    static_assert(base <= 256u);
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using PositionArray = typename MachineType::PositionArray;
+    using Index = IndexT;
+
+    static constexpr std::size_t max_crib = 1024u;
+    static constexpr std::size_t max_states = std::size_t{1u} << 24u;
+
+    PositionIndex() = delete;
+
+    // Constructor --
+    // Builds the index for `machine`, using `threads` threads (0 for one per
+    // hardware thread). Throws `std::invalid_argument` if the machine's
+    // period exceeds `max_states`.
+    //
+    explicit PositionIndex(MachineType const & machine, unsigned threads = 0u):
+        machine(machine) {
+
+      // Follow the cycle from the machine's positions.
+      auto order = std::vector<PositionArray>{};
+      auto walker = machine;
+      auto const start = walker.getPositions();
+      do {
+        order.push_back(walker.getPositions());
+        walker.advance();
+      } while (walker.getPositions() != start && order.size() < max_states);
+      if (walker.getPositions() != start) {
+        throw std::invalid_argument("period exceeds the index's max_states");
+      }
+
+      auto header = Header{};
+      std::memcpy(header.magic, magic, sizeof(magic));
+      header.symbols = base;
+      header.rotors = rotor_count;
+      header.period = order.size();
+      header.words = (header.period + max_crib + 63u) / 64u + 2u;
+      header.fingerprint = getFingerprint(machine);
+
+      auto owned = std::make_shared<std::vector<std::uint64_t>>(
+        getBlockWords(header));
+      std::memcpy(owned->data(), &header, sizeof(header));
+      storage = std::shared_ptr<void const>(owned, owned->data());
+      attach(owned->data());
+
+      auto * positions = reinterpret_cast<std::uint8_t *>(
+        owned->data() + header_words);
+      for (auto t = 0u; t < order.size(); ++t) {
+        for (auto i = 0u; i < rotor_count; ++i) {
+          positions[t * rotor_count + i] =
+            static_cast<std::uint8_t>(order[t][i]);
+        }
+      }
+
+      build(const_cast<std::uint64_t *>(bitmaps), order, threads);
+    }
+
+    // load --
+    // Maps an index saved by `save`. Returns nothing if the file cannot be
+    // read or was built for a different machine.
+    //
+    static std::optional<PositionIndex>
+    load(std::string const & path, MachineType const & machine) {
+      auto block = mapFile(path);
+      if (!block.first) {
+        return std::nullopt;
+      }
+
+      auto header = Header{};
+      if (block.second < sizeof(header)) {
+        return std::nullopt;
+      }
+      std::memcpy(&header, block.first.get(), sizeof(header));
+      if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+          header.symbols != base || header.rotors != rotor_count ||
+          header.fingerprint != getFingerprint(machine) ||
+          block.second != getBlockWords(header) * sizeof(std::uint64_t)) {
+        return std::nullopt;
+      }
+
+      auto index = PositionIndex{machine, std::move(block.first)};
+      return index;
+    }
+
+    // save --
+    // Writes the index to `path`. Returns false on failure.
+    //
+    bool save(std::string const & path) const {
+      auto file = std::ofstream{path, std::ios::binary};
+      auto bytes = getBlockWords(getHeader()) * sizeof(std::uint64_t);
+      file.write(static_cast<char const *>(storage.get()),
+                 static_cast<std::streamsize>(bytes));
+      return static_cast<bool>(file);
+    }
+
+    [[nodiscard]] std::size_t getPeriod() const {
+      return getHeader().period;
+    }
+
+    // isComplete --
+    // True if the cycle visits every combination of rotor positions.
+    //
+    [[nodiscard]] bool isComplete() const {
+      auto states = std::size_t{1u};
+      for (auto i = 0u; i < rotor_count; ++i) {
+        states *= base;
+      }
+      return getPeriod() == states;
+    }
+
+    // search --
+    // Returns every indexed starting position (before the first advance)
+    // under which the machine enciphers `plain` to `cipher`, in ascending
+    // order. Throws `std::invalid_argument` if a value is not below `base`.
+    //
+    [[nodiscard]] std::vector<PositionArray>
+    search(std::vector<Index> const & plain,
+           std::vector<Index> const & cipher) const {
+      assert(plain.size() == cipher.size());
+      for (auto i = 0u; i < plain.size(); ++i) {
+        if (plain[i] >= base || cipher[i] >= base) {
+          throw std::invalid_argument("crib value out of range");
+        }
+      }
+
+      auto const period = getPeriod();
+      auto const length = std::min(plain.size(), max_crib - 1u);
+      auto sources = std::vector<std::uint64_t const *>(length);
+      for (auto i = 0u; i < length; ++i) {
+        sources[i] = getBitmap(plain[i], cipher[i]);
+      }
+
+      auto candidates = std::vector<std::uint64_t>((period + 63u) / 64u);
+      intersect(sources, candidates);
+      if (period % 64u != 0u) {
+        candidates.back() &= (std::uint64_t{1u} << (period % 64u)) - 1u;
+      }
+
+      auto results = std::vector<PositionArray>{};
+      auto verifier = machine;
+      for (auto w = 0u; w < candidates.size(); ++w) {
+        for (auto bits = candidates[w]; bits != 0u; bits &= bits - 1u) {
+          auto t = w * 64u + static_cast<std::size_t>(countTrailing(bits));
+          auto start = getPositions(t);
+          verifier.setPositions(start);
+          auto matches = true;
+          for (auto i = 0u; i < plain.size() && matches; ++i) {
+            auto out = verifier.encodeNext(plain[i]);
+            matches = (i < length) || out == cipher[i];
+          }
+          if (matches) {
+            results.push_back(start);
+          }
+        }
+      }
+
+      std::sort(results.begin(), results.end());
+      return results;
+    }
+
+  private:
+
+    struct Header {
+      char magic[8];
+      std::uint32_t symbols;
+      std::uint32_t rotors;
+      std::uint64_t period;
+      std::uint64_t words;
+      std::uint64_t fingerprint;
+      std::uint64_t reserved[3];
+    };
+
+    static_assert(sizeof(Header) == 64u);
+
+    static constexpr char magic[8] = {'E', 'N', 'I', 'G', 'M', 'A', 'P', 'X'};
+    static constexpr std::size_t header_words = sizeof(Header) / 8u;
+
+    using Block = std::pair<std::shared_ptr<void const>, std::size_t>;
+
+    PositionIndex(MachineType const & machine,
+                  std::shared_ptr<void const> storage):
+        machine(machine),
+        storage(std::move(storage)) {
+      attach(static_cast<std::uint64_t const *>(this->storage.get()));
+    }
+
+    static std::size_t getPositionWords(Header const & header) {
+      return (header.period * rotor_count + 7u) / 8u;
+    }
+
+    static std::size_t getBlockWords(Header const & header) {
+      return header_words + getPositionWords(header) +
+             base * base * header.words;
+    }
+
+    // getFingerprint --
+    // Hash of the wiring, notches, reflector and starting positions.
+    //
+    static std::uint64_t getFingerprint(MachineType const & machine) {
+      auto hash = std::uint64_t{0xCBF29CE484222325u};
+      auto mix = [&hash](std::uint64_t value) {
+        hash = (hash ^ value) * 0x100000001B3u;
+      };
+      for (auto const & rotor : machine.getRotors()) {
+        for (auto val : rotor.getForwardCipher()) {
+          mix(val);
+        }
+        for (auto i = 0u; i < base; ++i) {
+          mix(rotor.getNotches()[i]);
+        }
+        mix(rotor.getPosition());
+      }
+      for (auto val : machine.getReflector()) {
+        mix(val);
+      }
+      return hash;
+    }
+
+    static Block mapFile(std::string const & path) {
+#if defined(ENIGMA_POSITION_INDEX_MMAP)
+      auto fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        return {};
+      }
+      struct stat info = {};
+      auto size = (::fstat(fd, &info) == 0) ?
+        static_cast<std::size_t>(info.st_size) : 0u;
+      auto * mapped = size > 0u ?
+        ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+      ::close(fd);
+      if (mapped == MAP_FAILED) {
+        return {};
+      }
+      auto release = [size](void const * memory) {
+        ::munmap(const_cast<void *>(memory), size);
+      };
+      return {std::shared_ptr<void const>(mapped, release), size};
+#else
+      auto file = std::ifstream{path, std::ios::binary | std::ios::ate};
+      if (!file) {
+        return {};
+      }
+      auto size = static_cast<std::size_t>(file.tellg());
+      auto owned = std::make_shared<std::vector<std::uint64_t>>(
+        (size + 7u) / 8u);
+      file.seekg(0);
+      file.read(reinterpret_cast<char *>(owned->data()),
+                static_cast<std::streamsize>(size));
+      if (!file) {
+        return {};
+      }
+      return {std::shared_ptr<void const>(owned, owned->data()), size};
+#endif
+    }
+
+    [[nodiscard]] Header getHeader() const {
+      auto header = Header{};
+      std::memcpy(&header, storage.get(), sizeof(header));
+      return header;
+    }
+
+    void attach(std::uint64_t const * block) {
+      auto header = getHeader();
+      words = header.words;
+      positions = reinterpret_cast<std::uint8_t const *>(block + header_words);
+      bitmaps = block + header_words + getPositionWords(header);
+    }
+
+    [[nodiscard]] PositionArray getPositions(std::size_t t) const {
+      auto result = PositionArray{};
+      for (auto i = 0u; i < rotor_count; ++i) {
+        result[i] = positions[t * rotor_count + i];
+      }
+      return result;
+    }
+
+    [[nodiscard]] std::uint64_t const * getBitmap(Index x, Index y) const {
+      return bitmaps + (x * base + y) * words;
+    }
+
+    static int countTrailing(std::uint64_t bits) {
+      auto count = 0;
+      for (; (bits & 1u) == 0u; bits >>= 1u) {
+        ++count;
+      }
+      return count;
+    }
+
+    // build --
+    // Fills the bitmaps. Threads take runs of 64 steps, so no two write to
+    // the same word.
+    //
+    void build(std::uint64_t * target, std::vector<PositionArray> const & order,
+               unsigned threads) const {
+      auto const period = order.size();
+      auto const runs = (period + 63u) / 64u;
+      auto next = std::atomic<std::size_t>{0u};
+
+      auto worker = [&] {
+        auto builder = machine;
+        for (auto run = next++; run < runs; run = next++) {
+          auto end = std::min(period, (run + 1u) * 64u);
+          for (auto t = run * 64u; t < end; ++t) {
+            builder.setPositions(order[t]);
+            for (auto x = 0u; x < base; ++x) {
+              auto y = builder.encode(static_cast<Index>(x));
+              target[(x * base + y) * words + run] |=
+                std::uint64_t{1u} << (t % 64u);
+            }
+          }
+        }
+      };
+
+      if (threads == 0u) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+      auto pool = std::vector<std::thread>{};
+      for (auto i = 1u; i < threads; ++i) {
+        pool.emplace_back(worker);
+      }
+      worker();
+      for (auto & thread : pool) {
+        thread.join();
+      }
+
+      // Repeat the start of each bitmap past the end of the period.
+      for (auto pair = 0u; pair < base * base; ++pair) {
+        auto * bitmap = target + pair * words;
+        for (auto t = period; t < period + max_crib; ++t) {
+          auto source = t - period;
+          if ((bitmap[source / 64u] >> (source % 64u)) & 1u) {
+            bitmap[t / 64u] |= std::uint64_t{1u} << (t % 64u);
+          }
+        }
+      }
+    }
+
+    // intersect --
+    // `out[w]` bit `b` = AND over `i` of bit `64w + b + i + 1` of
+    // `sources[i]`.
+    //
+    static void intersect(std::vector<std::uint64_t const *> const & sources,
+                          std::vector<std::uint64_t> & out) {
+      auto w = std::size_t{0u};
+#if defined(ENIGMA_POSITION_INDEX_AVX2)
+      if (__builtin_cpu_supports("avx2")) {
+        w = intersectAvx2(sources, out);
+      }
+#endif
+      for (; w < out.size(); ++w) {
+        auto acc = ~std::uint64_t{0u};
+        for (auto i = 0u; i < sources.size() && acc != 0u; ++i) {
+          acc &= extract(sources[i], w * 64u + i + 1u);
+        }
+        out[w] = acc;
+      }
+    }
+
+    // extract --
+    // 64 bits of `bitmap` starting at bit `offset`.
+    //
+    static std::uint64_t extract(std::uint64_t const * bitmap,
+                                 std::size_t offset) {
+      auto word = offset / 64u;
+      auto shift = offset % 64u;
+      if (shift == 0u) {
+        return bitmap[word];
+      }
+      return (bitmap[word] >> shift) | (bitmap[word + 1u] << (64u - shift));
+    }
+
+#if defined(ENIGMA_POSITION_INDEX_AVX2)
+    // intersectAvx2 --
+    // As `intersect`, four words at a time. Returns the number of words done.
+    //
+    __attribute__((target("avx2"))) static std::size_t
+    intersectAvx2(std::vector<std::uint64_t const *> const & sources,
+                  std::vector<std::uint64_t> & out) {
+      auto w = std::size_t{0u};
+      for (; w + 4u <= out.size(); w += 4u) {
+        auto acc = _mm256_set1_epi64x(-1);
+        for (auto i = 0u; i < sources.size(); ++i) {
+          auto offset = i + 1u;
+          auto const * bitmap = sources[i] + w + offset / 64u;
+          auto shift = static_cast<int>(offset % 64u);
+          auto lo = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(bitmap));
+          if (shift != 0) {
+            auto hi = _mm256_loadu_si256(
+              reinterpret_cast<__m256i const *>(bitmap + 1u));
+            lo = _mm256_or_si256(
+              _mm256_srl_epi64(lo, _mm_cvtsi32_si128(shift)),
+              _mm256_sll_epi64(hi, _mm_cvtsi32_si128(64 - shift)));
+          }
+          acc = _mm256_and_si256(acc, lo);
+          if ((i & 7u) == 7u && _mm256_testz_si256(acc, acc)) {
+            break;
+          }
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.data() + w), acc);
+      }
+      return w;
+    }
+#endif
+
+    MachineType machine;
+    std::shared_ptr<void const> storage;
+    std::size_t words = 0u;
+    std::uint8_t const * positions = nullptr;
+    std::uint64_t const * bitmaps = nullptr;
+  };
+
+  // PositionIndex class deduction guides --------------------------------------
+
+  template<class T, class ... Args> PositionIndex(T const &, Args && ...) ->
+    PositionIndex<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_POSITION_INDEX_HPP
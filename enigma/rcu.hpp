@@ -0,0 +1,241 @@
+#ifndef ENIGMA_RCU_HPP
+#define ENIGMA_RCU_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <limits>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <mutex>
+
+namespace enigma {
+
+  // RcuCell class -------------------------------------------------------------
+  // Holds one immutable `T`, such as the wiring or machine for a key, which
+  // can be replaced while other threads read it. Readers never block and
+  // never wait for a writer: a read section costs two loads and two stores to
+  // the reader's own cache line. A writer publishes a new object with one
+  // atomic exchange; readers already in a section keep the old object until
+  // they leave it, and readers entering afterwards see the new one.
+  //
+  // Replaced objects are reclaimed by epoch. Each publication advances a
+  // global epoch and retires the old object with the epoch it was replaced
+  // in. A reader records the epoch when it enters a section. A retired
+  // object is deleted once no reader is in a section entered at or before
+  // its retirement, checked by each `publish` and by `reclaim`. Writers are
+  // serialised by a mutex, which readers never take.
+  //
+  // Each reading thread registers a `Reader`, one section at a time. Reader
+  // slots are reused when a `Reader` is destroyed, and freed with the cell,
+  // which must outlive its readers.
+  //
+  template<class T>
+  class RcuCell {
+
+    static constexpr auto idle = std::numeric_limits<std::uint64_t>::max();
+
+    struct alignas(64) Slot {
+      std::atomic<std::uint64_t> epoch = idle;
+      std::atomic<bool> in_use = true;
+      Slot * next = nullptr;
+    };
+
+    struct Retired {
+      std::unique_ptr<T const> value;
+      std::uint64_t epoch;
+    };
+
+  public:
+
+    class Reader;
+    class ReadGuard;
+
+    RcuCell() = delete;
+
+    explicit RcuCell(std::unique_ptr<T const> value):
+        current(value.release()) {
+      assert(current.load() != nullptr);
+    }
+
+    RcuCell(RcuCell const &) = delete;
+    RcuCell & operator=(RcuCell const &) = delete;
+
+    ~RcuCell() {
+      delete current.load();
+      for (auto * slot = slots.load(); slot != nullptr;) {
+        assert(!slot->in_use.load());
+        delete std::exchange(slot, slot->next);
+      }
+    }
+
+    // makeReader --
+    // Registers a reader, reusing the slot of a destroyed one if possible.
+    //
+    [[nodiscard]] Reader makeReader() {
+      for (auto * slot = slots.load(); slot != nullptr; slot = slot->next) {
+        auto expected = false;
+        if (slot->in_use.compare_exchange_strong(expected, true)) {
+          return Reader{this, slot};
+        }
+      }
+      auto * slot = new Slot{};
+      slot->next = slots.load();
+      while (!slots.compare_exchange_weak(slot->next, slot)) {}
+      return Reader{this, slot};
+    }
+
+    // publish --
+    // Replaces the object. Readers in a section keep the previous object,
+    // which is deleted once they have all left. Returns the number of
+    // retired objects still waiting.
+    //
+    std::size_t publish(std::unique_ptr<T const> value) {
+      assert(value != nullptr);
+      auto lock = std::lock_guard{mutex};
+      auto * previous = current.exchange(value.release());
+      retired.push_back({std::unique_ptr<T const>{previous},
+                         epoch.fetch_add(1u)});
+      return reclaimLocked();
+    }
+
+    // reclaim --
+    // Deletes retired objects no reader can still hold. Returns the number
+    // still waiting.
+    //
+    std::size_t reclaim() {
+      auto lock = std::lock_guard{mutex};
+      return reclaimLocked();
+    }
+
+    // getEpoch --
+    // Number of publications so far, plus one.
+    //
+    [[nodiscard]] std::uint64_t getEpoch() const {
+      return epoch.load(std::memory_order_relaxed);
+    }
+
+  private:
+
+    std::size_t reclaimLocked() {
+      auto oldest = idle;
+      for (auto * slot = slots.load(); slot != nullptr; slot = slot->next) {
+        oldest = std::min(oldest, slot->epoch.load());
+      }
+      auto reclaimable = [oldest](Retired const & entry) {
+        return entry.epoch < oldest;
+      };
+      retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                   reclaimable),
+                    retired.end());
+      return retired.size();
+    }
+
+    std::atomic<T const *> current;
+    std::atomic<std::uint64_t> epoch = 1u;
+    std::atomic<Slot *> slots = nullptr;
+    std::vector<Retired> retired;
+    std::mutex mutex;
+  };
+
+  // RcuCell::Reader class -----------------------------------------------------
+  // A registered reader. May be used by one thread at a time, for one
+  // section at a time.
+  //
+  template<class T>
+  class RcuCell<T>::Reader {
+  public:
+
+    Reader(Reader && other) noexcept:
+        cell(std::exchange(other.cell, nullptr)),
+        slot(std::exchange(other.slot, nullptr)) {}
+
+    Reader & operator=(Reader && other) noexcept {
+      release();
+      cell = std::exchange(other.cell, nullptr);
+      slot = std::exchange(other.slot, nullptr);
+      return *this;
+    }
+
+    ~Reader() {
+      release();
+    }
+
+    // lock --
+    // Enters a read section. The object returned stays valid, and is not
+    // replaced for this reader, until the guard is destroyed.
+    //
+    [[nodiscard]] ReadGuard lock() {
+      assert(slot->epoch.load(std::memory_order_relaxed) == idle);
+
+      // Sequentially consistent, so that a writer which misses this store
+      // while reclaiming has already published the object loaded here.
+      slot->epoch.store(cell->epoch.load());
+      return ReadGuard{slot, cell->current.load()};
+    }
+
+  private:
+
+    friend class RcuCell;
+
+    Reader(RcuCell * cell, Slot * slot):
+        cell(cell), slot(slot) {}
+
+    void release() {
+      if (slot != nullptr) {
+        assert(slot->epoch.load(std::memory_order_relaxed) == idle);
+        slot->in_use.store(false, std::memory_order_release);
+      }
+    }
+
+    RcuCell * cell = nullptr;
+    Slot * slot = nullptr;
+  };
+
+  // RcuCell::ReadGuard class --------------------------------------------------
+  // A read section, ended by destruction.
+  //
+  template<class T>
+  class RcuCell<T>::ReadGuard {
+  public:
+
+    ReadGuard(ReadGuard const &) = delete;
+    ReadGuard & operator=(ReadGuard const &) = delete;
+
+    ~ReadGuard() {
+      slot->epoch.store(idle, std::memory_order_release);
+    }
+
+    [[nodiscard]] T const & operator*() const {
+      return *value;
+    }
+
+    [[nodiscard]] T const * operator->() const {
+      return value;
+    }
+
+    [[nodiscard]] T const * get() const {
+      return value;
+    }
+
+  private:
+
+    friend class Reader;
+
+    ReadGuard(Slot * slot, T const * value):
+        slot(slot), value(value) {}
+
+    Slot * slot;
+    T const * value;
+  };
+
+}
+
+#endif // ENIGMA_RCU_HPP
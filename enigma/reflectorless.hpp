@@ -0,0 +1,209 @@
+#ifndef ENIGMA_REFLECTORLESS_HPP
+#define ENIGMA_REFLECTORLESS_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <array>
+
+#include "enigma.hpp"
+#include "util.hpp"
+
+namespace enigma {
+
+  // ReflectorlessMachine class ------------------------------------------------
+  // A rotor machine without a reflector. Values pass forward through the
+  // rotor assembly once, so encoding is never reciprocal and decoding takes
+  // the inverse path. Rotors step as in `EnigmaMachine`.
+  //
+  // Like `CompositeMachine`, a stack of composites is cached, one per rotor
+  // level: the composite for level `k` folds rotors `k` to `rotor_count - 1`
+  // into one table, and its inverse is kept alongside. Encoding and decoding
+  // each take two lookups after the first rotor, whatever the number of
+  // rotors, and only the levels which moved are rebuilt when stepping.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class ReflectorlessMachine {
+  public:
+
+    static_assert(rotor_count > 0u);
+
+    using Index = IndexT;
+    using RotorType = Rotor<Index, base>;
+    using RotorArray = std::array<RotorType, rotor_count>;
+    using CipherArray = std::array<Index, base>;
+    using PositionArray = std::array<std::size_t, rotor_count>;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    ReflectorlessMachine() = delete;
+
+    // Constructor --
+    // `rotors` - A `std::array` of `Rotor` objects, or an object convertible
+    //            to said type. Turnover callbacks are not used; stepping is
+    //            handled by the machine.
+    //
+    template<class RotorsT>
+    explicit ReflectorlessMachine(RotorsT && rotors):
+        rotors(std::forward<RotorsT>(rotors)) {
+
+      auto const & first = this->rotors[0];
+      for (auto i = 0u; i < 2u * base; ++i) {
+        first_forward[i] = first.getForwardCipher()[i % base];
+        first_reverse[i] = first.getReverseCipher()[i % base];
+        wrap[i] = static_cast<Index>(i % base);
+      }
+
+      for (auto val = 0u; val < base; ++val) {
+        layers[rotor_count][val] = static_cast<Index>(val);
+        inverse[rotor_count][val] = static_cast<Index>(val);
+      }
+
+      for (auto i = 0u; i < rotor_count; ++i) {
+        positions[i] = this->rotors[i].getPosition();
+      }
+      rebuild(rotor_count - 1u);
+    }
+
+    [[nodiscard]] RotorArray const & getRotors() const {
+      return rotors;
+    }
+
+    [[nodiscard]] PositionArray const & getPositions() const {
+      return positions;
+    }
+
+    void setPositions(PositionArray const & positions) {
+      this->positions = positions;
+      rebuild(rotor_count - 1u);
+    }
+
+    // advance --
+    // Advance by `steps`, carrying between rotors as `Rotor::advance` does.
+    //
+    void advance(std::size_t steps = 1u) {
+      if (steps == 1u) {
+        auto level = carry(0u);
+        if (level > 0u) {
+          rebuild(level);
+        }
+        return;
+      }
+
+      // Seek each rotor arithmetically, passing its turnovers on as steps.
+      auto top = std::size_t{0u};
+      for (auto i = 0u; i < rotor_count && steps > 0u; ++i) {
+        auto & rotor = rotors[i];
+        rotor.setPosition(positions[i]);
+        auto knocks = rotor.countKnocks(steps);
+        positions[i] = (positions[i] + steps % base) % base;
+        top = i;
+        steps = knocks;
+      }
+      rebuild(top);
+    }
+
+    [[nodiscard]] Index encode(Index val) const {
+      assert(val < base);
+      return layers[1u][first_forward[positions[0] + val]];
+    }
+
+    [[nodiscard]] Index decode(Index val) const {
+      assert(val < base);
+      return wrap[first_reverse[inverse[1u][val]] + base - positions[0]];
+    }
+
+    Index encodeNext(Index val) {
+      advance();
+      return encode(val);
+    }
+
+    Index decodeNext(Index val) {
+      advance();
+      return decode(val);
+    }
+
+    // encodeNext --
+    // Batch form of `encodeNext`. Encodes the values in `[first, last)` to
+    // `out`, advancing before each one.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = encodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+    // decodeNext --
+    // Batch form of `decodeNext`.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt decodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = decodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+  private:
+
+    std::size_t carry(std::size_t level) {
+      while (true) {
+        if (++positions[level] == base) {
+          positions[level] = 0u;
+        }
+        if (level + 1u == rotor_count ||
+            !rotors[level].getNotches()[positions[level]]) {
+          return level;
+        }
+        ++level;
+      }
+    }
+
+    void rebuild(std::size_t top) {
+      for (auto level = top; level > 0u; --level) {
+        auto const & forward = rotors[level].getForwardCipher();
+        auto const & next = layers[level + 1u];
+        auto offset = positions[level];
+        for (auto val = 0u; val < base; ++val) {
+          auto out = next[forward[(offset + val) % base]];
+          layers[level][val] = out;
+          inverse[level][out] = static_cast<Index>(val);
+        }
+      }
+    }
+
+    RotorArray rotors;
+    PositionArray positions;
+    std::array<Index, 2u * base> first_forward;
+    std::array<Index, 2u * base> first_reverse;
+    std::array<Index, 2u * base> wrap;
+
+    // Composites for levels 1 to `rotor_count`, where the last is the
+    // identity, so a single rotor machine needs no special case.
+    std::array<CipherArray, rotor_count + 1u> layers;
+    std::array<CipherArray, rotor_count + 1u> inverse;
+  };
+
+  // ReflectorlessMachine class deduction guides -------------------------------
+
+  template<class T>
+  ReflectorlessMachine(T &&) ->
+    ReflectorlessMachine<deduce_rotor_index_t<util::array_value_t<T>>,
+                         deduce_rotor_base_v<util::array_value_t<T>>,
+                         util::array_size_v<T>>;
+
+}
+
+#endif // ENIGMA_REFLECTORLESS_HPP
@@ -0,0 +1,98 @@
+#ifndef ENIGMA_RING_HPP
+#define ENIGMA_RING_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <cstddef>
+#include <utility>
+#include <atomic>
+#include <array>
+
+namespace enigma {
+
+  // SpscRing class ------------------------------------------------------------
+  // Bounded lock-free queue for exactly one producer thread and one consumer
+  // thread. Each side caches the other's index and only reloads it (with
+  // acquire ordering) when the ring looks full or empty, so in steady state
+  // neither side touches the other's cache line.
+  //
+  // `T` - Element type. Must be default constructible and assignable.
+  // `capacity` - Number of slots, must be a power of two.
+  //
+  template<class T, std::size_t capacity>
+  class SpscRing {
+  public:
+
+    static_assert(capacity > 0u && (capacity & (capacity - 1u)) == 0u);
+
+    static constexpr std::size_t getCapacity() {
+      return capacity;
+    }
+
+    // tryPush --
+    // Called by the producer. Returns false if the ring is full.
+    //
+    template<class U>
+    bool tryPush(U && value) {
+      auto tail = producer.index.load(std::memory_order_relaxed);
+      if (tail - producer.cached >= capacity) {
+        producer.cached = consumer.index.load(std::memory_order_acquire);
+        if (tail - producer.cached >= capacity) {
+          return false;
+        }
+      }
+      slots[tail & (capacity - 1u)] = std::forward<U>(value);
+      producer.index.store(tail + 1u, std::memory_order_release);
+      return true;
+    }
+
+    // front --
+    // Called by the consumer. Returns the oldest element, or null if the ring
+    // is empty. The element stays valid until `pop`.
+    //
+    T * front() {
+      auto head = consumer.index.load(std::memory_order_relaxed);
+      if (head == consumer.cached) {
+        consumer.cached = producer.index.load(std::memory_order_acquire);
+        if (head == consumer.cached) {
+          return nullptr;
+        }
+      }
+      return &slots[head & (capacity - 1u)];
+    }
+
+    // pop --
+    // Called by the consumer after a successful `front`.
+    //
+    void pop() {
+      auto head = consumer.index.load(std::memory_order_relaxed);
+      consumer.index.store(head + 1u, std::memory_order_release);
+    }
+
+    // getSize --
+    // Approximate number of queued elements, safe from any thread.
+    //
+    [[nodiscard]] std::size_t getSize() const {
+      // Head first: the tail can only have grown by the time it is read.
+      auto head = consumer.index.load(std::memory_order_acquire);
+      auto tail = producer.index.load(std::memory_order_acquire);
+      return static_cast<std::size_t>(tail - head);
+    }
+
+  private:
+
+    struct alignas(64) Side {
+      std::atomic<std::size_t> index = 0u;
+      std::size_t cached = 0u;
+    };
+
+    Side producer;
+    Side consumer;
+    std::array<T, capacity> slots;
+  };
+
+}
+
+#endif // ENIGMA_RING_HPP
@@ -0,0 +1,397 @@
+#ifndef ENIGMA_SIGABA_HPP
+#define ENIGMA_SIGABA_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <type_traits>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <limits>
+#include <array>
+
+#include "enigma.hpp"
+
+namespace enigma {
+
+  // SigabaMachine class -------------------------------------------------------
+  // Reference model of a SIGABA-style machine, built from `Rotor` objects.
+  // Three banks of `bank_size` rotors:
+  //
+  //  - Cipher rotors encipher the input, forward only (no reflector). Each
+  //    steps independently, under control of the other two banks.
+  //  - Control rotors are driven through a fixed set of energised inputs.
+  //    The middle rotor steps on every key press, the next after each of its
+  //    revolutions and the second after each revolution of that; the outer
+  //    two stay put. Their outputs are gathered into groups (`ControlGroups`)
+  //    feeding the index bank.
+  //  - Index rotors (of `index_base` contacts) are set once and do not step.
+  //    Their outputs are gathered into one line per cipher rotor
+  //    (`IndexGroups`). Each cipher rotor whose line is energised steps.
+  //
+  // Like `EnigmaMachine`, the machine advances before each value is
+  // enciphered. See `SigabaEngine` for a fast implementation of the same
+  // machine.
+  //
+  template<class IndexT, std::size_t base = 26u, std::size_t index_base = 10u>
+  class SigabaMachine {
+  public:
+
+    static_assert(std::numeric_limits<IndexT>::max() >= base);
+    static_assert(std::is_unsigned_v<IndexT>);
+    static_assert(index_base <= base);
+
+    static constexpr std::size_t bank_size = 5u;
+
+    using Index = IndexT;
+    using RotorType = Rotor<Index, base>;
+    using IndexRotorType = Rotor<Index, index_base>;
+    using BankArray = std::array<RotorType, bank_size>;
+    using IndexBankArray = std::array<IndexRotorType, bank_size>;
+    using ControlGroups = std::array<Index, base>;
+    using IndexGroups = std::array<Index, index_base>;
+    using InputArray = std::array<Index, 4u>;
+
+    // Control outputs which feed no index input.
+    static constexpr Index none = std::numeric_limits<Index>::max();
+
+    // Control bank inputs energised on every key press (F, G, H and I).
+    static constexpr InputArray energised = {5u, 6u, 7u, 8u};
+
+    // Control bank rotors, by role.
+    static constexpr std::size_t slow = 1u;
+    static constexpr std::size_t fast = 2u;
+    static constexpr std::size_t medium = 3u;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    // getHistoricalControlGroups --
+    // Gathering of control outputs into index inputs, after Stamp and Chan:
+    // A to 9, B to 1, C to 2, D-E to 3, F-H to 4, I-K to 5, L-O to 6,
+    // P-T to 7 and U-Z to 8. Index input 0 is unused.
+    //
+    static constexpr ControlGroups getHistoricalControlGroups() {
+      static_assert(base == 26u && index_base == 10u);
+      constexpr std::size_t sizes[] = {1u, 1u, 1u, 2u, 3u, 3u, 4u, 5u, 6u};
+      constexpr Index groups[] = {9u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u};
+      auto result = ControlGroups{};
+      auto output = std::size_t{0u};
+      for (auto i = 0u; i < 9u; ++i) {
+        for (auto j = 0u; j < sizes[i]; ++j) {
+          result[output++] = groups[i];
+        }
+      }
+      return result;
+    }
+
+    // getHistoricalIndexGroups --
+    // Index outputs paired onto cipher rotor lines: 0-9, 1-2, 3-4, 5-6, 7-8.
+    //
+    static constexpr IndexGroups getHistoricalIndexGroups() {
+      static_assert(index_base == 10u);
+      return {0u, 1u, 1u, 2u, 2u, 3u, 3u, 4u, 4u, 0u};
+    }
+
+    SigabaMachine() = delete;
+
+    SigabaMachine(BankArray cipher, BankArray control, IndexBankArray index,
+                  ControlGroups control_groups = getHistoricalControlGroups(),
+                  IndexGroups index_groups = getHistoricalIndexGroups()):
+        cipher(std::move(cipher)),
+        control(std::move(control)),
+        index(std::move(index)),
+        control_groups(control_groups),
+        index_groups(index_groups) {}
+
+    [[nodiscard]] BankArray const & getCipherRotors() const {
+      return cipher;
+    }
+
+    [[nodiscard]] BankArray const & getControlRotors() const {
+      return control;
+    }
+
+    [[nodiscard]] IndexBankArray const & getIndexRotors() const {
+      return index;
+    }
+
+    [[nodiscard]] ControlGroups const & getControlGroups() const {
+      return control_groups;
+    }
+
+    [[nodiscard]] IndexGroups const & getIndexGroups() const {
+      return index_groups;
+    }
+
+    // getSteppingMask --
+    // Bit `i` is set if cipher rotor `i` steps on the next advance.
+    //
+    [[nodiscard]] unsigned getSteppingMask() const {
+      auto mask = 0u;
+      for (auto input : energised) {
+        auto val = input;
+        for (auto const & rotor : control) {
+          val = rotor.doForwardCipher(val);
+        }
+
+        auto group = control_groups[val];
+        if (group == none) {
+          continue;
+        }
+        for (auto const & rotor : index) {
+          group = rotor.doForwardCipher(group);
+        }
+        mask |= 1u << index_groups[group];
+      }
+      return mask;
+    }
+
+    void advance() {
+      auto mask = getSteppingMask();
+      for (auto i = 0u; i < bank_size; ++i) {
+        if (mask & (1u << i)) {
+          cipher[i].advance();
+        }
+      }
+
+      if (control[fast].advance() == 0u && control[medium].advance() == 0u) {
+        control[slow].advance();
+      }
+    }
+
+    [[nodiscard]] Index encode(Index val) const {
+      for (auto const & rotor : cipher) {
+        val = rotor.doForwardCipher(val);
+      }
+      return val;
+    }
+
+    [[nodiscard]] Index decode(Index val) const {
+      for (auto it = cipher.rbegin(); it != cipher.rend(); ++it) {
+        val = it->undoForwardCipher(val);
+      }
+      return val;
+    }
+
+    Index encodeNext(Index val) {
+      advance();
+      return encode(val);
+    }
+
+    Index decodeNext(Index val) {
+      advance();
+      return decode(val);
+    }
+
+  private:
+
+    BankArray cipher;
+    BankArray control;
+    IndexBankArray index;
+    ControlGroups control_groups;
+    IndexGroups index_groups;
+  };
+
+  // SigabaEngine class --------------------------------------------------------
+  // Fast implementation of a `SigabaMachine`, producing identical output.
+  //
+  // The stepping decision depends only on the control rotors, as the index
+  // bank is static. The index bank and control output groups are folded into
+  // a single table mapping each control output to a cipher rotor mask. The
+  // control bank is then split by rate of motion:
+  //
+  //  - the energised inputs through the two leftmost rotors, which change at
+  //    most once per `base * base` steps;
+  //  - the two rightmost rotors and the mask table, which change once per
+  //    revolution of the fast rotor.
+  //
+  // Each time the fast rotor completes a revolution, both halves are joined
+  // across every position of the fast rotor into a table of `base` stepping
+  // masks, all four inputs at once. Each step then takes one lookup to decide
+  // which cipher rotors move.
+  //
+  // Cipher rotors are applied directly through tables doubled in length to
+  // avoid a modulo. Their composite is not cached: one or more of them moves
+  // on every key press, so a cached composite would be rebuilt every step.
+  //
+  template<class IndexT, std::size_t base = 26u, std::size_t index_base = 10u>
+  class SigabaEngine {
+  public:
+
+    using MachineType = SigabaMachine<IndexT, base, index_base>;
+    using Index = IndexT;
+
+    static constexpr std::size_t bank_size = MachineType::bank_size;
+
+    explicit SigabaEngine(MachineType const & machine) {
+      auto const & cipher = machine.getCipherRotors();
+      auto const & control = machine.getControlRotors();
+
+      for (auto i = 0u; i < bank_size; ++i) {
+        for (auto j = 0u; j < 2u * base; ++j) {
+          cipher_forward[i][j] = cipher[i].getForwardCipher()[j % base];
+          cipher_reverse[i][j] = cipher[i].getReverseCipher()[j % base];
+          control_forward[i][j] = control[i].getForwardCipher()[j % base];
+        }
+        cipher_positions[i] = cipher[i].getPosition();
+        control_positions[i] = control[i].getPosition();
+      }
+
+      for (auto j = 0u; j < 2u * base; ++j) {
+        wrap[j] = static_cast<Index>(j % base);
+      }
+
+      // Control output to cipher rotor mask, through the static index bank.
+      auto const & index = machine.getIndexRotors();
+      for (auto out = 0u; out < base; ++out) {
+        auto group = machine.getControlGroups()[out];
+        if (group == MachineType::none) {
+          output_masks[out] = 0u;
+          continue;
+        }
+        for (auto const & rotor : index) {
+          group = rotor.doForwardCipher(group);
+        }
+        output_masks[out] = static_cast<std::uint8_t>(
+          1u << machine.getIndexGroups()[group]);
+      }
+
+      rebuildInputs();
+      rebuildMasks();
+    }
+
+    [[nodiscard]] unsigned getSteppingMask() const {
+      return step_masks[control_positions[MachineType::fast]];
+    }
+
+    void advance() {
+      auto mask = getSteppingMask();
+      // Branch free, as the masks follow no predictable pattern.
+      for (auto i = 0u; i < bank_size; ++i) {
+        cipher_positions[i] = wrap[cipher_positions[i] + ((mask >> i) & 1u)];
+      }
+
+      if (stepControl(MachineType::fast)) {
+        if (stepControl(MachineType::medium)) {
+          stepControl(MachineType::slow);
+          rebuildInputs();
+        }
+        rebuildMasks();
+      }
+    }
+
+    [[nodiscard]] Index encode(Index val) const {
+      for (auto i = 0u; i < bank_size; ++i) {
+        val = cipher_forward[i][cipher_positions[i] + val];
+      }
+      return val;
+    }
+
+    [[nodiscard]] Index decode(Index val) const {
+      for (auto i = bank_size; i-- > 0u;) {
+        val = wrap[cipher_reverse[i][val] + base - cipher_positions[i]];
+      }
+      return val;
+    }
+
+    Index encodeNext(Index val) {
+      advance();
+      return encode(val);
+    }
+
+    Index decodeNext(Index val) {
+      advance();
+      return decode(val);
+    }
+
+    template<class InputIt, class OutputIt>
+    OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = encodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+    template<class InputIt, class OutputIt>
+    OutputIt decodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = decodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+  private:
+
+    using Table = std::array<Index, 2u * base>;
+    using InputArray = typename MachineType::InputArray;
+
+    // stepControl --
+    // Steps a control rotor. Returns true if it completed a revolution.
+    //
+    bool stepControl(std::size_t rotor) {
+      if (++control_positions[rotor] == base) {
+        control_positions[rotor] = 0u;
+        return true;
+      }
+      return false;
+    }
+
+    [[nodiscard]] Index applyControl(std::size_t rotor, Index val) const {
+      return control_forward[rotor][control_positions[rotor] + val];
+    }
+
+    // rebuildInputs --
+    // The energised inputs through the first two control rotors.
+    //
+    void rebuildInputs() {
+      for (auto i = 0u; i < inputs.size(); ++i) {
+        auto val = applyControl(0u, MachineType::energised[i]);
+        inputs[i] = applyControl(1u, val);
+      }
+    }
+
+    // rebuildMasks --
+    // The stepping mask for every position of the fast rotor.
+    //
+    void rebuildMasks() {
+      auto tail = std::array<std::uint8_t, base>{};
+      for (auto val = 0u; val < base; ++val) {
+        auto out = applyControl(4u, applyControl(3u, val));
+        tail[val] = output_masks[out];
+      }
+
+      auto const & fast = control_forward[MachineType::fast];
+      for (auto position = 0u; position < base; ++position) {
+        auto mask = std::uint8_t{0u};
+        for (auto input : inputs) {
+          mask |= tail[fast[position + input]];
+        }
+        step_masks[position] = mask;
+      }
+    }
+
+    std::array<Table, bank_size> cipher_forward;
+    std::array<Table, bank_size> cipher_reverse;
+    std::array<Table, bank_size> control_forward;
+    Table wrap;
+    std::array<std::size_t, bank_size> cipher_positions;
+    std::array<std::size_t, bank_size> control_positions;
+    std::array<std::uint8_t, base> output_masks;
+    std::array<std::uint8_t, base> step_masks;
+    InputArray inputs;
+  };
+
+  // SigabaEngine class deduction guides ---------------------------------------
+
+  template<class IndexT, std::size_t base, std::size_t index_base>
+  SigabaEngine(SigabaMachine<IndexT, base, index_base> const &) ->
+    SigabaEngine<IndexT, base, index_base>;
+
+}
+
+#endif // ENIGMA_SIGABA_HPP
@@ -0,0 +1,829 @@
+#ifndef ENIGMA_SPEC_HPP
+#define ENIGMA_SPEC_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <string_view>
+#include <stdexcept>
+#include <optional>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <array>
+
+#include "enigma.hpp"
+
+namespace enigma::spec {
+
+  // Machine description language ----------------------------------------------
+  // A machine is described by a short text, one directive per line. Anything
+  // after a `#` is a comment. For example, the machine built by `main.cpp`:
+  //
+  //   alphabet  ABCDEFGHIJKLMNOPQRSTUVWXYZ
+  //   rotor     BDFHJLCPRTXVZNYEIWGAKMUSQO notches W
+  //   rotor     AJDKSIRUXBLHWTMCQGZNPYFVOE notches F
+  //   rotor     EKMFLGDQVZNTOWYHXUSPAIBRCJ notches R
+  //   reflector YRUHQSLDPXNGOKMIEBFZCWVJAT
+  //
+  // Directives:
+  //
+  //  - `alphabet SYMBOLS` - The symbols enciphered, at most 254 of them.
+  //    Defaults to A-Z. Letters also match their other case, if it is not a
+  //    symbol itself. Must precede any directive naming symbols.
+  //  - `rotor WIRING [notches SYMBOLS] [position SYMBOL]` - A wheel which
+  //    steps. Notches are positions at which the next rotor is knocked on,
+  //    as with `Rotor`.
+  //  - `stator WIRING [position SYMBOL]` - A wheel which never steps.
+  //  - `reflector WIRING` - Optional. Without one the signal passes through
+  //    the wheels once, as with `ReflectorlessMachine`.
+  //  - `plugboard PAIRS...` - Symbols swapped on entry and exit.
+  //  - `stepping odometer|fixed` - Odometer stepping (the default) advances
+  //    the first rotor on every symbol and carries as `EnigmaMachine` does.
+  //    Fixed machines never step.
+  //  - `kernel auto|direct|composite|full` - Overrides the kernel choice (see
+  //    `Machine`). `composite` needs a stepping rotor and `full` a machine
+  //    which never steps.
+  //
+  // Wheels are listed from the entry side outward; the first rotor listed is
+  // the fastest. A wiring maps the n-th symbol of the alphabet to its n-th
+  // symbol.
+  //
+
+  enum class Stepping {
+    odometer,
+    fixed
+  };
+
+  enum class Kernel {
+    direct,
+    composite,
+    full
+  };
+
+  [[nodiscard]] inline std::string_view getKernelName(Kernel kernel) {
+    switch (kernel) {
+      case Kernel::direct: return "direct";
+      case Kernel::composite: return "composite";
+      case Kernel::full: return "full";
+    }
+    return "unknown";
+  }
+
+  // Spec structs --------------------------------------------------------------
+  // A parsed description, with every symbol converted to its code point.
+  //
+
+  struct WheelSpec {
+    std::vector<std::uint8_t> wiring;
+    std::vector<std::uint8_t> notches;
+    std::size_t position = 0u;
+    bool fixed = false;
+  };
+
+  struct Spec {
+    std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    std::vector<WheelSpec> wheels;
+    std::vector<std::uint8_t> reflector;
+    std::vector<std::uint8_t> plugboard;
+    Stepping stepping = Stepping::odometer;
+    std::optional<Kernel> kernel;
+  };
+
+  // Alphabet class ------------------------------------------------------------
+  // Runtime counterpart of `LatinAlphabet`, for use with `encodeStream`.
+  //
+  class Alphabet {
+  public:
+
+    static constexpr std::uint8_t none = 0xFFu;
+
+    Alphabet() = delete;
+
+    explicit Alphabet(std::string const & symbols): symbols(symbols) {
+      assert(!symbols.empty() && symbols.size() < none);
+      indices.fill(none);
+      for (auto i = 0u; i < symbols.size(); ++i) {
+        indices[static_cast<unsigned char>(symbols[i])] =
+          static_cast<std::uint8_t>(i);
+      }
+      for (auto i = 0u; i < symbols.size(); ++i) {
+        auto c = static_cast<unsigned char>(symbols[i]);
+        auto other = swapCase(c);
+        if (other != c && indices[other] == none) {
+          indices[other] = static_cast<std::uint8_t>(i);
+        }
+      }
+    }
+
+    [[nodiscard]] std::size_t getSize() const {
+      return symbols.size();
+    }
+
+    [[nodiscard]] std::string const & getSymbols() const {
+      return symbols;
+    }
+
+    [[nodiscard]] std::uint8_t toIndex(unsigned char c) const {
+      return indices[c];
+    }
+
+    // toChar --
+    // Maps `index` back to a symbol, taking the case of `original` when the
+    // symbol was matched through its other case.
+    //
+    [[nodiscard]] unsigned char
+    toChar(std::uint8_t index, unsigned char original) const {
+      if (index == none) {
+        return original;
+      }
+      auto c = static_cast<unsigned char>(symbols[index]);
+      auto matched = indices[original];
+      auto folded = matched != none &&
+        static_cast<unsigned char>(symbols[matched]) != original;
+      if (folded && indices[swapCase(c)] == index) {
+        return swapCase(c);
+      }
+      return c;
+    }
+
+  private:
+
+    static unsigned char swapCase(unsigned char c) {
+      if (c >= 'A' && c <= 'Z') {
+        return static_cast<unsigned char>(c - 'A' + 'a');
+      }
+      if (c >= 'a' && c <= 'z') {
+        return static_cast<unsigned char>(c - 'a' + 'A');
+      }
+      return c;
+    }
+
+    std::string symbols;
+    std::array<std::uint8_t, 256u> indices;
+  };
+
+  namespace detail {
+
+    [[noreturn]] inline void fail(std::size_t line, std::string const & what) {
+      throw std::invalid_argument(
+        "line " + std::to_string(line) + ": " + what);
+    }
+
+    inline std::uint8_t parseSymbol(std::string const & alphabet,
+                                    char symbol, std::size_t line) {
+      auto found = alphabet.find(symbol);
+      if (found == std::string::npos) {
+        fail(line, std::string{"'"} + symbol + "' is not in the alphabet");
+      }
+      return static_cast<std::uint8_t>(found);
+    }
+
+    inline std::vector<std::uint8_t>
+    parseWiring(std::string const & alphabet, std::string const & wiring,
+                std::size_t line) {
+      if (wiring.size() != alphabet.size()) {
+        fail(line, "wiring '" + wiring + "' does not match the alphabet size");
+      }
+      auto result = std::vector<std::uint8_t>{};
+      auto seen = std::vector<bool>(alphabet.size(), false);
+      for (auto symbol : wiring) {
+        auto index = parseSymbol(alphabet, symbol, line);
+        if (seen[index]) {
+          fail(line, std::string{"wiring repeats '"} + symbol + "'");
+        }
+        seen[index] = true;
+        result.push_back(index);
+      }
+      return result;
+    }
+
+  }
+
+  // parse --
+  // Parses a machine description. Throws `std::invalid_argument`, naming the
+  // offending line, if it is malformed.
+  //
+  inline Spec parse(std::istream & is) {
+    auto spec = Spec{};
+    auto has_alphabet = false;
+    auto has_symbols = false;
+    auto has_reflector = false;
+    auto has_plugboard = false;
+
+    auto text = std::string{};
+    for (auto line = std::size_t{1u}; std::getline(is, text); ++line) {
+      auto words = std::vector<std::string>{};
+      auto stream = std::istringstream{text.substr(0u, text.find('#'))};
+      for (auto word = std::string{}; stream >> word;) {
+        words.push_back(word);
+      }
+      if (words.empty()) {
+        continue;
+      }
+
+      auto const & directive = words[0];
+      auto const & alphabet = spec.alphabet;
+
+      if (directive == "alphabet") {
+        if (words.size() != 2u) {
+          detail::fail(line, "expected 'alphabet SYMBOLS'");
+        }
+        if (has_alphabet || has_symbols) {
+          detail::fail(line, "alphabet must come first, and only once");
+        }
+        auto const & symbols = words[1];
+        if (symbols.size() < 2u || symbols.size() >= Alphabet::none) {
+          detail::fail(line, "alphabet must have 2 to 254 symbols");
+        }
+        for (auto i = 0u; i < symbols.size(); ++i) {
+          if (symbols.find(symbols[i]) != i) {
+            detail::fail(line, "alphabet repeats '" + symbols.substr(i, 1u) +
+                               "'");
+          }
+        }
+        spec.alphabet = symbols;
+        has_alphabet = true;
+
+      } else if (directive == "rotor" || directive == "stator") {
+        if (words.size() < 2u) {
+          detail::fail(line, "expected '" + directive + " WIRING'");
+        }
+        auto wheel = WheelSpec{};
+        wheel.wiring = detail::parseWiring(alphabet, words[1], line);
+        wheel.fixed = (directive == "stator");
+
+        for (auto i = 2u; i < words.size(); i += 2u) {
+          if (i + 1u == words.size()) {
+            detail::fail(line, "'" + words[i] + "' expects a value");
+          }
+          auto const & value = words[i + 1u];
+          if (words[i] == "position" && value.size() == 1u) {
+            wheel.position = detail::parseSymbol(alphabet, value[0], line);
+          } else if (words[i] == "notches" && !wheel.fixed) {
+            for (auto symbol : value) {
+              wheel.notches.push_back(
+                detail::parseSymbol(alphabet, symbol, line));
+            }
+          } else {
+            detail::fail(line, "unexpected '" + words[i] + " " + value + "'");
+          }
+        }
+        spec.wheels.push_back(std::move(wheel));
+
+      } else if (directive == "reflector") {
+        if (words.size() != 2u || has_reflector) {
+          detail::fail(line, "expected one 'reflector WIRING'");
+        }
+        spec.reflector = detail::parseWiring(alphabet, words[1], line);
+        has_reflector = true;
+
+      } else if (directive == "plugboard") {
+        if (has_plugboard) {
+          detail::fail(line, "plugboard given twice");
+        }
+        spec.plugboard.resize(alphabet.size());
+        for (auto i = 0u; i < alphabet.size(); ++i) {
+          spec.plugboard[i] = static_cast<std::uint8_t>(i);
+        }
+        for (auto i = 1u; i < words.size(); ++i) {
+          auto const & pair = words[i];
+          if (pair.size() != 2u) {
+            detail::fail(line, "plug '" + pair + "' is not a pair");
+          }
+          auto a = detail::parseSymbol(alphabet, pair[0], line);
+          auto b = detail::parseSymbol(alphabet, pair[1], line);
+          if (a == b || spec.plugboard[a] != a || spec.plugboard[b] != b) {
+            detail::fail(line, "plug '" + pair + "' reuses a symbol");
+          }
+          spec.plugboard[a] = b;
+          spec.plugboard[b] = a;
+        }
+        has_plugboard = true;
+
+      } else if (directive == "stepping") {
+        if (words.size() != 2u) {
+          detail::fail(line, "expected 'stepping odometer|fixed'");
+        }
+        if (words[1] == "odometer") {
+          spec.stepping = Stepping::odometer;
+        } else if (words[1] == "fixed") {
+          spec.stepping = Stepping::fixed;
+        } else {
+          detail::fail(line, "unknown stepping '" + words[1] + "'");
+        }
+
+      } else if (directive == "kernel") {
+        if (words.size() != 2u) {
+          detail::fail(line, "expected 'kernel auto|direct|composite|full'");
+        }
+        if (words[1] == "auto") {
+          spec.kernel.reset();
+        } else if (words[1] == "direct") {
+          spec.kernel = Kernel::direct;
+        } else if (words[1] == "composite") {
+          spec.kernel = Kernel::composite;
+        } else if (words[1] == "full") {
+          spec.kernel = Kernel::full;
+        } else {
+          detail::fail(line, "unknown kernel '" + words[1] + "'");
+        }
+
+      } else {
+        detail::fail(line, "unknown directive '" + directive + "'");
+      }
+
+      // Only directives which name symbols fix the alphabet.
+      has_symbols = has_symbols || directive == "rotor" ||
+                    directive == "stator" || directive == "reflector" ||
+                    directive == "plugboard";
+    }
+
+    if (spec.wheels.empty()) {
+      throw std::invalid_argument("a machine needs at least one wheel");
+    }
+
+    auto steps = spec.stepping == Stepping::odometer &&
+      std::any_of(spec.wheels.begin(), spec.wheels.end(),
+                  [](auto const & wheel) { return !wheel.fixed; });
+    if (spec.kernel == Kernel::full && steps) {
+      throw std::invalid_argument("the full kernel needs a fixed machine");
+    }
+    if (spec.kernel == Kernel::composite && !steps) {
+      throw std::invalid_argument(
+        "the composite kernel needs a stepping rotor");
+    }
+
+    return spec;
+  }
+
+  inline Spec parse(std::string const & text) {
+    auto stream = std::istringstream{text};
+    return parse(stream);
+  }
+
+  // Machine class -------------------------------------------------------------
+  // A machine built from a `Spec` at runtime, compiled into an execution plan
+  // around one of three kernels:
+  //
+  //  - `full` - Machines which never step are folded into a single table,
+  //    one lookup per symbol.
+  //  - `composite` - Everything before the first rotor is folded into per
+  //    position entry and exit tables for that rotor, and everything beyond
+  //    it into a cached composite (see `CompositeMachine`), rebuilt whenever
+  //    a later rotor moves. Three lookups per symbol with a reflector, two
+  //    without.
+  //  - `direct` - Each stage is applied in turn. Chosen when the first rotor
+  //    carries so often that rebuilding the composite costs more than it
+  //    saves.
+  //
+  // Output is the same whichever kernel runs. Each kernel keeps the inverses
+  // of its tables, from which `decode` undoes `encode`.
+  //
+  class Machine {
+  public:
+
+    using Index = std::uint8_t;
+
+    Machine() = delete;
+
+    explicit Machine(Spec const & spec):
+        alphabet(spec.alphabet),
+        base(spec.alphabet.size()),
+        reflector(spec.reflector) {
+
+      assert(!spec.wheels.empty());
+
+      if (!reflector.empty()) {
+        reflector_inverse.resize(base);
+        for (auto i = 0u; i < base; ++i) {
+          reflector_inverse[reflector[i]] = static_cast<Index>(i);
+        }
+      }
+
+      plugboard = spec.plugboard;
+      if (plugboard.empty()) {
+        plugboard.resize(base);
+        for (auto i = 0u; i < base; ++i) {
+          plugboard[i] = static_cast<Index>(i);
+        }
+      }
+
+      for (auto const & wheel_spec : spec.wheels) {
+        assert(wheel_spec.wiring.size() == base);
+        auto wheel = Wheel{};
+        wheel.forward.resize(2u * base);
+        wheel.reverse.resize(2u * base);
+        for (auto i = 0u; i < 2u * base; ++i) {
+          auto out = wheel_spec.wiring[i % base];
+          wheel.forward[i] = out;
+          wheel.reverse[out + (i < base ? 0u : base)] =
+            static_cast<Index>(i % base);
+        }
+        auto notches = std::vector<bool>(base, false);
+        for (auto notch : wheel_spec.notches) {
+          notches[notch] = true;
+        }
+        wheel.knocks.resize(2u * base + 1u);
+        fillKnocks(wheel.knocks, notches, base);
+        wheel.position = wheel_spec.position;
+        if (!wheel_spec.fixed && spec.stepping == Stepping::odometer) {
+          rotors.push_back(wheels.size());
+        }
+        wheels.push_back(std::move(wheel));
+      }
+
+      // A composite needs a first rotor; a machine without one is folded
+      // into a single table instead.
+      kernel = spec.kernel ? *spec.kernel : chooseKernel();
+      if (kernel == Kernel::composite && rotors.empty()) {
+        kernel = Kernel::full;
+      }
+      assert(kernel != Kernel::full || rotors.empty());
+      compile();
+    }
+
+    [[nodiscard]] Alphabet const & getAlphabet() const {
+      return alphabet;
+    }
+
+    [[nodiscard]] std::size_t getBase() const {
+      return base;
+    }
+
+    [[nodiscard]] Kernel getKernel() const {
+      return kernel;
+    }
+
+    [[nodiscard]] std::size_t getRotorCount() const {
+      return rotors.size();
+    }
+
+    // getPositions --
+    // Positions of every wheel, stators included, in the order listed.
+    //
+    [[nodiscard]] std::vector<std::size_t> getPositions() const {
+      auto positions = std::vector<std::size_t>{};
+      for (auto const & wheel : wheels) {
+        positions.push_back(wheel.position);
+      }
+      return positions;
+    }
+
+    // getRotorPosition --
+    // Position of the stepping rotor at `level`, fastest first.
+    //
+    [[nodiscard]] std::size_t getRotorPosition(std::size_t level) const {
+      assert(level < rotors.size());
+      return wheels[rotors[level]].position;
+    }
+
+    // setRotorPositions --
+    // Sets every stepping rotor, fastest first, from the `getRotorCount()`
+    // values at `first`, without turnovers.
+    //
+    template<class InputIt>
+    void setRotorPositions(InputIt first) {
+      for (auto level = 0u; level < rotors.size(); ++level, ++first) {
+        assert(static_cast<std::size_t>(*first) < base);
+        wheels[rotors[level]].position = static_cast<std::size_t>(*first);
+      }
+      if (kernel == Kernel::composite) {
+        rebuildInner();
+      }
+    }
+
+    // advance --
+    // Advance by `steps`. A single step carries between rotors; longer seeks
+    // count each rotor's turnovers arithmetically.
+    //
+    void advance(std::size_t steps = 1u) {
+      if (rotors.empty() || steps == 0u) {
+        return;
+      }
+
+      auto top = std::size_t{0u};
+      if (steps == 1u) {
+        top = carry(0u);
+      } else {
+        for (auto level = 0u; level < rotors.size() && steps > 0u; ++level) {
+          auto & wheel = wheels[rotors[level]];
+          auto knocks = countKnocks(wheel.knocks, base, wheel.position, steps);
+          wheel.position = (wheel.position + steps % base) % base;
+          top = level;
+          steps = knocks;
+        }
+      }
+
+      if (top > 0u && kernel == Kernel::composite) {
+        rebuildInner();
+      }
+    }
+
+    [[nodiscard]] Index encode(Index val) const {
+      assert(val < base);
+      switch (kernel) {
+        case Kernel::full:
+          return full[val];
+        case Kernel::composite: {
+          auto row = wheels[rotors[0]].position * base;
+          auto inner = tail[entry[row + val]];
+          return reflector.empty() ? inner : exit[row + inner];
+        }
+        case Kernel::direct:
+          break;
+      }
+      return encodeDirect(val);
+    }
+
+    Index encodeNext(Index val) {
+      advance();
+      return encode(val);
+    }
+
+    // encodeNext --
+    // Batch form of `encodeNext`. The kernel is dispatched once per call.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      if (kernel != Kernel::composite) {
+        for (; first != last; ++first, ++out) {
+          *out = encodeNext(static_cast<Index>(*first));
+        }
+        return out;
+      }
+
+      auto & first_rotor = wheels[rotors[0]];
+      auto const reflected = !reflector.empty();
+      auto const carries = rotors.size() > 1u;
+      for (; first != last; ++first, ++out) {
+        if (++first_rotor.position == base) {
+          first_rotor.position = 0u;
+        }
+        if (carries && first_rotor.isNotch(first_rotor.position)) {
+          carry(1u);
+          rebuildInner();
+        }
+        auto row = first_rotor.position * base;
+        auto val = tail[entry[row + static_cast<Index>(*first)]];
+        *out = reflected ? exit[row + val] : val;
+      }
+      return out;
+    }
+
+    // decode --
+    // Inverse of `encode` at the current positions.
+    //
+    [[nodiscard]] Index decode(Index val) const {
+      assert(val < base);
+      switch (kernel) {
+        case Kernel::full:
+          return full_inverse[val];
+        case Kernel::composite: {
+          auto row = wheels[rotors[0]].position * base;
+          auto inner = reflector.empty() ? val : exit_inverse[row + val];
+          return entry_inverse[row + tail_inverse[inner]];
+        }
+        case Kernel::direct:
+          break;
+      }
+      return decodeDirect(val);
+    }
+
+    Index decodeNext(Index val) {
+      advance();
+      return decode(val);
+    }
+
+    // decodeNext --
+    // Batch form of `decodeNext`.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt decodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = decodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+  private:
+
+    struct Wheel {
+      // Ciphers repeated over two revolutions, avoiding a modulo.
+      std::vector<Index> forward;
+      std::vector<Index> reverse;
+
+      // Prefix counts of notches over two revolutions (see `fillKnocks`).
+      std::vector<std::size_t> knocks;
+      std::size_t position = 0u;
+
+      [[nodiscard]] bool isNotch(std::size_t position) const {
+        return hasNotch(knocks, position);
+      }
+
+      [[nodiscard]] Index forwardAt(Index val) const {
+        return forward[position + val];
+      }
+
+      [[nodiscard]] Index reverseAt(Index val) const {
+        return reverse[position + val];
+      }
+
+      // Inverses of `forwardAt` and `reverseAt`.
+
+      [[nodiscard]] Index undoForwardAt(Index val, std::size_t base) const {
+        return static_cast<Index>((reverse[val] + base - position) % base);
+      }
+
+      [[nodiscard]] Index undoReverseAt(Index val, std::size_t base) const {
+        return static_cast<Index>((forward[val] + base - position) % base);
+      }
+    };
+
+    // carry --
+    // Steps the rotor at `level`, carrying onward through notches. Returns
+    // the last level stepped.
+    //
+    std::size_t carry(std::size_t level) {
+      while (true) {
+        auto & wheel = wheels[rotors[level]];
+        if (++wheel.position == base) {
+          wheel.position = 0u;
+        }
+        if (level + 1u == rotors.size() || !wheel.isNotch(wheel.position)) {
+          return level;
+        }
+        ++level;
+      }
+    }
+
+    // chooseKernel --
+    // Compares the estimated cost per symbol of each kernel, in table
+    // lookups. Lookups while rebuilding count as half: each entry of the
+    // composite is independent of the others, so they overlap well.
+    //
+    [[nodiscard]] Kernel chooseKernel() const {
+      if (rotors.empty()) {
+        return Kernel::full;
+      }
+
+      auto passes = reflector.empty() ? 1u : 2u;
+      auto direct = double(passes * wheels.size() + 2u);
+
+      auto const & first = wheels[rotors[0]];
+      auto inner_stages = passes * (wheels.size() - rotors[0] - 1u) + 1u;
+      auto carry_rate = rotors.size() > 1u ? double(first.knocks[base]) / base
+                                           : 0.0;
+      auto composite = passes + 1.0 + carry_rate * base * inner_stages / 2.0;
+
+      return composite < direct ? Kernel::composite : Kernel::direct;
+    }
+
+    [[nodiscard]] Index encodeDirect(Index val) const {
+      val = plugboard[val];
+      for (auto const & wheel : wheels) {
+        val = wheel.forwardAt(val);
+      }
+      if (!reflector.empty()) {
+        val = reflector[val];
+        for (auto it = wheels.rbegin(); it != wheels.rend(); ++it) {
+          val = it->reverseAt(val);
+        }
+      }
+      return plugboard[val];
+    }
+
+    [[nodiscard]] Index decodeDirect(Index val) const {
+      val = plugboard[val];
+      if (!reflector.empty()) {
+        for (auto const & wheel : wheels) {
+          val = wheel.undoReverseAt(val, base);
+        }
+        val = reflector_inverse[val];
+      }
+      for (auto it = wheels.rbegin(); it != wheels.rend(); ++it) {
+        val = it->undoForwardAt(val, base);
+      }
+      return plugboard[val];
+    }
+
+    // invert --
+    // Writes the inverse of the permutation `base` entries at `table` to
+    // `inverse`.
+    //
+    void invert(Index const * table, Index * inverse) const {
+      for (auto val = 0u; val < base; ++val) {
+        inverse[table[val]] = static_cast<Index>(val);
+      }
+    }
+
+    void compile() {
+      if (kernel == Kernel::full) {
+        full.resize(base);
+        for (auto val = 0u; val < base; ++val) {
+          full[val] = encodeDirect(static_cast<Index>(val));
+        }
+        full_inverse.resize(base);
+        invert(full.data(), full_inverse.data());
+        return;
+      }
+
+      if (kernel != Kernel::composite) {
+        return;
+      }
+
+      // Static stages on either side of the first rotor.
+      auto const first = rotors[0];
+      auto const & rotor = wheels[first];
+      auto outer_in = std::vector<Index>(base);
+      auto outer_out = std::vector<Index>(base);
+      for (auto val = 0u; val < base; ++val) {
+        auto in = plugboard[val];
+        auto out = static_cast<Index>(val);
+        for (auto i = 0u; i < first; ++i) {
+          in = wheels[i].forwardAt(in);
+        }
+        for (auto i = first; i-- > 0u;) {
+          out = wheels[i].reverseAt(out);
+        }
+        outer_in[val] = in;
+        outer_out[val] = plugboard[out];
+      }
+
+      entry.resize(base * base);
+      exit.resize(base * base);
+      for (auto position = 0u; position < base; ++position) {
+        auto row = position * base;
+        for (auto val = 0u; val < base; ++val) {
+          entry[row + val] = rotor.forward[position + outer_in[val]];
+          exit[row + val] = outer_out[rotor.reverse[position + val]];
+        }
+      }
+      entry_inverse.resize(base * base);
+      exit_inverse.resize(base * base);
+      for (auto row = 0u; row < base * base; row += base) {
+        invert(entry.data() + row, entry_inverse.data() + row);
+        invert(exit.data() + row, exit_inverse.data() + row);
+      }
+
+      tail.resize(base);
+      tail_inverse.resize(base);
+      rebuildInner();
+    }
+
+    // rebuildInner --
+    // Composite of every stage beyond the first rotor. Without a reflector
+    // this includes the exit through the plugboard.
+    //
+    void rebuildInner() {
+      auto const first = rotors[0];
+      for (auto val = 0u; val < base; ++val) {
+        auto out = static_cast<Index>(val);
+        for (auto i = first + 1u; i < wheels.size(); ++i) {
+          out = wheels[i].forwardAt(out);
+        }
+        if (reflector.empty()) {
+          tail[val] = plugboard[out];
+          continue;
+        }
+        out = reflector[out];
+        for (auto i = wheels.size(); i-- > first + 1u;) {
+          out = wheels[i].reverseAt(out);
+        }
+        tail[val] = out;
+      }
+      invert(tail.data(), tail_inverse.data());
+    }
+
+    Alphabet alphabet;
+    std::size_t base;
+    std::vector<Index> reflector;
+    std::vector<Index> reflector_inverse;
+    std::vector<Index> plugboard;
+    std::vector<Wheel> wheels;
+
+    // Indices into `wheels` of the stepping wheels, fastest first.
+    std::vector<std::size_t> rotors;
+
+    Kernel kernel;
+    std::vector<Index> full;
+    std::vector<Index> entry;
+    std::vector<Index> exit;
+    std::vector<Index> tail;
+
+    // Inverses of the tables above, for `decode`.
+    std::vector<Index> full_inverse;
+    std::vector<Index> entry_inverse;
+    std::vector<Index> exit_inverse;
+    std::vector<Index> tail_inverse;
+  };
+
+}
+
+#endif // ENIGMA_SPEC_HPP
@@ -0,0 +1,205 @@
+#ifndef ENIGMA_STREAM_HPP
+#define ENIGMA_STREAM_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <functional>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <chrono>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace enigma {
+
+  // LatinAlphabet class -------------------------------------------------------
+  // Maps the letters of the latin alphabet onto code points 0 to 25, ignoring
+  // case. Any other byte is not a symbol and maps to `none`.
+  //
+  class LatinAlphabet {
+  public:
+
+    static constexpr std::size_t size = 26u;
+    static constexpr std::uint8_t none = 0xFFu;
+
+    [[nodiscard]] static constexpr std::uint8_t toIndex(unsigned char c) {
+      if (c >= 'A' && c <= 'Z') {
+        return static_cast<std::uint8_t>(c - 'A');
+      }
+      if (c >= 'a' && c <= 'z') {
+        return static_cast<std::uint8_t>(c - 'a');
+      }
+      return none;
+    }
+
+    // toChar --
+    // Maps `index` back to a letter with the same case as `original`, the byte
+    // it was mapped from. Non-symbols are returned unchanged.
+    //
+    [[nodiscard]] static constexpr unsigned char
+    toChar(std::uint8_t index, unsigned char original) {
+      if (index == none) {
+        return original;
+      }
+      auto first = (original >= 'a' && original <= 'z') ? 'a' : 'A';
+      return static_cast<unsigned char>(first + index);
+    }
+  };
+
+  // Stream pipeline stages ----------------------------------------------------
+  // Each stage processes one chunk. The machine advances once per byte, symbol
+  // or not, so the position of any byte in a stream is its offset. This keeps
+  // chunks independent of their content and allows seeking by byte offset.
+  //
+
+  // mapChunk --
+  // Maps `bytes` to code points. Returns the number of symbols.
+  //
+  template<class AlphabetT = LatinAlphabet>
+  std::size_t mapChunk(std::vector<char> const & bytes,
+                       std::vector<std::uint8_t> & indices,
+                       AlphabetT const & alphabet = {}) {
+    auto symbols = std::size_t{0u};
+    indices.resize(bytes.size());
+    for (auto i = 0u; i < bytes.size(); ++i) {
+      indices[i] = alphabet.toIndex(static_cast<unsigned char>(bytes[i]));
+      symbols += (indices[i] != AlphabetT::none);
+    }
+    return symbols;
+  }
+
+  template<class MachineT, class AlphabetT = LatinAlphabet>
+  void encodeChunk(MachineT & machine, std::vector<std::uint8_t> & indices) {
+    for (auto & index : indices) {
+      if (index != AlphabetT::none) {
+        index = machine.encodeNext(index);
+      } else {
+        machine.advance();
+      }
+    }
+  }
+
+  template<class AlphabetT = LatinAlphabet>
+  void unmapChunk(std::vector<std::uint8_t> const & indices,
+                  std::vector<char> & bytes,
+                  AlphabetT const & alphabet = {}) {
+    for (auto i = 0u; i < bytes.size(); ++i) {
+      auto original = static_cast<unsigned char>(bytes[i]);
+      bytes[i] = static_cast<char>(alphabet.toChar(indices[i], original));
+    }
+  }
+
+  // Decoder class -------------------------------------------------------------
+  // Adapts `MachineT` so that the stream stages decipher: `encodeNext` calls
+  // the machine's `decodeNext`. Deciphering a stream from the same starting
+  // positions recovers what was enciphered, the machine again advancing
+  // once per byte.
+  //
+  template<class MachineT>
+  class Decoder {
+  public:
+
+    using Index = typename MachineT::Index;
+
+    Decoder() = delete;
+
+    explicit Decoder(MachineT & machine):
+        machine(machine) {}
+
+    void advance() {
+      machine.advance();
+    }
+
+    Index encodeNext(Index val) {
+      return machine.decodeNext(val);
+    }
+
+  private:
+
+    MachineT & machine;
+  };
+
+  // ChunkStats struct ---------------------------------------------------------
+  // Passed to the optional per-chunk callback of `encodeStream`.
+  //
+  struct ChunkStats {
+    std::uint64_t chunk;
+    std::size_t bytes;
+    std::size_t symbols;
+    double encode_seconds;
+  };
+
+  using ChunkFunc = std::function<void(ChunkStats const &)>;
+
+  // encodeStream --
+  // Reads `is` to exhaustion in chunks of `chunk_size` bytes, enciphers every
+  // symbol with `machine` and writes the result to `os`. Each stage is traced
+  // (see `trace::Recorder`) and `on_chunk`, if set, is invoked after each
+  // chunk is written. Returns the number of bytes processed.
+  //
+  // `AlphabetT` maps bytes to code points through `toIndex` and `toChar`,
+  // either static or bound to `alphabet`, and names non-symbols `none`.
+  //
+  template<class MachineT, class AlphabetT = LatinAlphabet>
+  std::uint64_t encodeStream(MachineT & machine, std::istream & is,
+                             std::ostream & os,
+                             std::size_t chunk_size = 1u << 16u,
+                             ChunkFunc const & on_chunk = {},
+                             AlphabetT const & alphabet = {}) {
+    using Clock = std::chrono::steady_clock;
+
+    auto bytes = std::vector<char>(chunk_size);
+    auto indices = std::vector<std::uint8_t>{};
+    auto total = std::uint64_t{0u};
+    auto symbols = std::size_t{0u};
+    auto encode_time = Clock::duration{};
+
+    for (auto chunk = std::uint64_t{0u}; is; ++chunk) {
+      {
+        auto scope = trace::Scope{"read", chunk};
+        is.read(bytes.data(), static_cast<std::streamsize>(chunk_size));
+        bytes.resize(static_cast<std::size_t>(is.gcount()));
+      }
+
+      if (bytes.empty()) {
+        break;
+      }
+
+      {
+        auto scope = trace::Scope{"map", chunk};
+        symbols = mapChunk<AlphabetT>(bytes, indices, alphabet);
+      }
+
+      {
+        auto scope = trace::Scope{"encode", chunk};
+        auto begin = Clock::now();
+        encodeChunk<MachineT, AlphabetT>(machine, indices);
+        encode_time = Clock::now() - begin;
+      }
+
+      {
+        auto scope = trace::Scope{"write", chunk};
+        unmapChunk<AlphabetT>(indices, bytes, alphabet);
+        os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+      }
+
+      if (on_chunk) {
+        auto seconds = std::chrono::duration<double>(encode_time).count();
+        on_chunk({chunk, bytes.size(), symbols, seconds});
+      }
+
+      total += bytes.size();
+      bytes.resize(chunk_size);
+    }
+
+    os.flush();
+    return total;
+  }
+
+}
+
+#endif // ENIGMA_STREAM_HPP
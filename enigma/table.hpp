@@ -0,0 +1,182 @@
+#ifndef ENIGMA_TABLE_HPP
+#define ENIGMA_TABLE_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include <array>
+
+#include "enigma.hpp"
+
+namespace enigma {
+
+  // TableMachine class --------------------------------------------------------
+  // Produces the same output as an `EnigmaMachine` from one table holding
+  // the machine's complete permutation for every combination of rotor
+  // positions: `base` to the power of `rotor_count + 1` entries. Encoding is
+  // a single lookup, and stepping only tracks which row is current.
+  //
+  // Building the table costs a full encode per entry, so it only pays for
+  // long messages, and is only practical for small shapes (see
+  // `isPractical`).
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count>
+  class TableMachine {
+  public:
+
+    static_assert(rotor_count > 0u);
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using Index = IndexT;
+    using PositionArray = typename MachineType::PositionArray;
+
+    // Largest table built, in entries.
+    static constexpr std::size_t max_table_size = std::size_t{1u} << 24u;
+
+    static constexpr std::size_t getBase() {
+      return base;
+    }
+
+    static constexpr std::size_t getRotorCount() {
+      return rotor_count;
+    }
+
+    // isPractical --
+    // True if the table for this shape is at most `max_table_size` entries.
+    //
+    static constexpr bool isPractical() {
+      auto size = base;
+      for (auto i = 0u; i < rotor_count; ++i) {
+        if (size > max_table_size / base) {
+          return false;
+        }
+        size *= base;
+      }
+      return true;
+    }
+
+    TableMachine() = delete;
+
+    explicit TableMachine(MachineType const & machine):
+        machine(machine),
+        positions(machine.getPositions()) {
+
+      assert(isPractical());
+
+      auto state_count = std::size_t{1u};
+      for (auto i = 0u; i < rotor_count; ++i) {
+        state_count *= base;
+      }
+
+      // State `s` holds rotor `i` at position `(s / base^i) % base`.
+      table.resize(state_count * base);
+      auto builder = machine;
+      auto state = PositionArray{};
+      for (auto s = std::size_t{0u}; s < state_count; ++s) {
+        auto rest = s;
+        for (auto i = 0u; i < rotor_count; ++i) {
+          state[i] = rest % base;
+          rest /= base;
+        }
+        builder.setPositions(state);
+        for (auto val = 0u; val < base; ++val) {
+          table[s * base + val] = builder.encode(static_cast<Index>(val));
+        }
+      }
+
+      updateRow();
+    }
+
+    [[nodiscard]] PositionArray const & getPositions() const {
+      return positions;
+    }
+
+    void setPositions(PositionArray const & positions) {
+      this->positions = positions;
+      updateRow();
+    }
+
+    void advance(std::size_t steps = 1u) {
+      if (steps == 1u) {
+        step();
+        return;
+      }
+
+      machine.setPositions(positions);
+      machine.advance(steps);
+      positions = machine.getPositions();
+      updateRow();
+    }
+
+    [[nodiscard]] Index encode(Index val) const {
+      assert(val < base);
+      return table[(row + positions[0]) * base + val];
+    }
+
+    Index encodeNext(Index val) {
+      step();
+      return encode(val);
+    }
+
+    // encodeNext --
+    // Batch form of `encodeNext`.
+    //
+    template<class InputIt, class OutputIt>
+    OutputIt encodeNext(InputIt first, InputIt last, OutputIt out) {
+      for (; first != last; ++first, ++out) {
+        *out = encodeNext(static_cast<Index>(*first));
+      }
+      return out;
+    }
+
+  private:
+
+    void step() {
+      auto const & rotors = machine.getRotors();
+      if (++positions[0] == base) {
+        positions[0] = 0u;
+      }
+      if (rotor_count == 1u || !rotors[0].getNotches()[positions[0]]) {
+        return;
+      }
+
+      for (auto level = 1u; level < rotor_count; ++level) {
+        if (++positions[level] == base) {
+          positions[level] = 0u;
+        }
+        if (level + 1u == rotor_count ||
+            !rotors[level].getNotches()[positions[level]]) {
+          break;
+        }
+      }
+      updateRow();
+    }
+
+    // updateRow --
+    // State index of the current positions, excluding the first rotor.
+    //
+    void updateRow() {
+      row = 0u;
+      for (auto i = rotor_count; i-- > 1u;) {
+        row = (row + positions[i]) * base;
+      }
+    }
+
+    MachineType machine;
+    PositionArray positions;
+    std::size_t row = 0u;
+    std::vector<Index> table;
+  };
+
+  // TableMachine class deduction guides ---------------------------------------
+
+  template<class T> TableMachine(T const &) ->
+    TableMachine<typename T::Index, T::getBase(), T::getRotorCount()>;
+
+}
+
+#endif // ENIGMA_TABLE_HPP
@@ -0,0 +1,210 @@
+#ifndef ENIGMA_TRACE_HPP
+#define ENIGMA_TRACE_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace enigma::trace {
+
+  // Event struct --------------------------------------------------------------
+  // A completed stage: `name` must have static storage duration (string
+  // literals). Timestamps are nanoseconds since the recorder was enabled.
+  //
+  struct Event {
+    char const * name;
+    std::uint64_t chunk;
+    std::uint64_t begin;
+    std::uint64_t end;
+  };
+
+  // Buffer class --------------------------------------------------------------
+  // Fixed capacity event store owned by a single thread. The owning thread is
+  // the only writer; it fills a slot then publishes it by a release store of
+  // `size`, so readers never observe partially written events and the writer
+  // never waits. Events recorded once the buffer is full are dropped.
+  //
+  class Buffer {
+  public:
+
+    Buffer(std::uint32_t thread_id, std::size_t capacity):
+        events(new Event[capacity]),
+        capacity(capacity),
+        thread_id(thread_id) {}
+
+    void push(Event const & event) {
+      auto index = size.load(std::memory_order_relaxed);
+      if (index < capacity) {
+        events[index] = event;
+        size.store(index + 1u, std::memory_order_release);
+      } else {
+        dropped.fetch_add(1u, std::memory_order_relaxed);
+      }
+    }
+
+    [[nodiscard]] std::size_t getSize() const {
+      return size.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::size_t getDropped() const {
+      return dropped.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Event const & operator[](std::size_t index) const {
+      return events[index];
+    }
+
+    [[nodiscard]] std::uint32_t getThreadId() const {
+      return thread_id;
+    }
+
+    Buffer * next = nullptr;
+
+  private:
+
+    std::unique_ptr<Event[]> events;
+    std::size_t capacity;
+    std::atomic<std::size_t> size = 0u;
+    std::atomic<std::size_t> dropped = 0u;
+    std::uint32_t thread_id;
+  };
+
+  // Recorder class ------------------------------------------------------------
+  // Process wide trace collector. Disabled by default, in which case `Scope`
+  // costs a single relaxed load. Once enabled each thread lazily allocates its
+  // own `Buffer` on first use and links it into an intrusive list with a CAS,
+  // so recording never takes a lock. Buffers live until the process exits.
+  //
+  class Recorder {
+  public:
+
+    static Recorder & getInstance() {
+      static auto recorder = Recorder{};
+      return recorder;
+    }
+
+    // enable --
+    // Start recording. `capacity` is the maximum number of events kept per
+    // thread. Must be called before any traced work starts.
+    //
+    void enable(std::size_t capacity = 1u << 16u) {
+      buffer_capacity = capacity;
+      origin = Clock::now();
+      enabled.store(true, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool isEnabled() const {
+      return enabled.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::uint64_t now() const {
+      auto elapsed = Clock::now() - origin;
+      return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    void record(Event const & event) {
+      thread_local Buffer * buffer = nullptr;
+      if (buffer == nullptr) {
+        buffer = addBuffer();
+      }
+      buffer->push(event);
+    }
+
+    // writeChromeTrace --
+    // Writes all recorded events as Chrome trace JSON ("X" complete events,
+    // microsecond timestamps), loadable in chrome://tracing or Perfetto. Only
+    // events published before the call are included.
+    //
+    void writeChromeTrace(std::ostream & os) const {
+      auto flags = os.flags();
+      os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+      auto separator = "\n";
+      auto dropped = std::size_t{0u};
+
+      for (auto buffer = head.load(std::memory_order_acquire);
+           buffer != nullptr; buffer = buffer->next) {
+        auto size = buffer->getSize();
+        for (auto i = 0u; i < size; ++i) {
+          auto const & event = (*buffer)[i];
+          os << separator
+             << "{\"name\":\"" << event.name << "\",\"cat\":\"pipeline\""
+             << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->getThreadId()
+             << ",\"ts\":" << (event.begin / 1000.0)
+             << ",\"dur\":" << ((event.end - event.begin) / 1000.0)
+             << ",\"args\":{\"chunk\":" << event.chunk << "}}";
+          separator = ",\n";
+        }
+        dropped += buffer->getDropped();
+      }
+
+      os << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":"
+         << dropped << "}}\n";
+      os.flags(flags);
+    }
+
+  private:
+
+    using Clock = std::chrono::steady_clock;
+
+    Recorder() = default;
+
+    Buffer * addBuffer() {
+      auto id = next_thread_id.fetch_add(1u, std::memory_order_relaxed);
+      auto buffer = new Buffer(id, buffer_capacity);
+      buffer->next = head.load(std::memory_order_relaxed);
+      while (!head.compare_exchange_weak(buffer->next, buffer,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {}
+      return buffer;
+    }
+
+    std::atomic<bool> enabled = false;
+    std::atomic<Buffer *> head = nullptr;
+    std::atomic<std::uint32_t> next_thread_id = 1u;
+    std::size_t buffer_capacity = 0u;
+    Clock::time_point origin;
+  };
+
+  // Scope class ---------------------------------------------------------------
+  // Records the lifetime of the enclosing scope as a stage of `chunk`.
+  //
+  class Scope {
+  public:
+
+    Scope(char const * name, std::uint64_t chunk):
+        recorder(Recorder::getInstance()),
+        event{name, chunk, 0u, 0u},
+        active(recorder.isEnabled()) {
+      if (active) {
+        event.begin = recorder.now();
+      }
+    }
+
+    Scope(Scope const &) = delete;
+    Scope & operator=(Scope const &) = delete;
+
+    ~Scope() {
+      if (active) {
+        event.end = recorder.now();
+        recorder.record(event);
+      }
+    }
+
+  private:
+
+    Recorder & recorder;
+    Event event;
+    bool active;
+  };
+
+}
+
+#endif // ENIGMA_TRACE_HPP
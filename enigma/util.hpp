@@ -5,7 +5,11 @@
 #error Minimum language standard requirement not met (C++17).
 #endif
 
+#include <type_traits>
+#include <algorithm>
 #include <numeric>
+#include <cstddef>
+#include <array>
 
 namespace util {
 
@@ -0,0 +1,331 @@
+#ifndef ENIGMA_VIEW_HPP
+#define ENIGMA_VIEW_HPP
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error Minimum language standard requirement not met (C++17).
+#endif
+
+#include <type_traits>
+#include <iterator>
+#include <utility>
+#include <memory>
+#include <cassert>
+#include <cstddef>
+#include <array>
+
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+#include <ranges>
+#define ENIGMA_VIEW_RANGES 1
+#endif
+
+#include "enigma.hpp"
+
+namespace enigma {
+
+  namespace detail {
+
+#if defined(ENIGMA_VIEW_RANGES)
+    template<class T>
+    using EncodedViewBase = std::ranges::view_interface<T>;
+#else
+    template<class T>
+    struct EncodedViewBase {};
+#endif
+
+  }
+
+  // EncodedView class ---------------------------------------------------------
+  // Lazy view of a random access range of symbols as enciphered by an
+  // `EnigmaMachine`: element `i` is the value `encodeNext` would return for
+  // the `i`th symbol, starting from the machine's positions when the view is
+  // made. Nothing is enciphered until an element is read, and the machine
+  // is not modified.
+  //
+  // Iterators seek as random access iterators. Each holds the rotor
+  // positions for its element, so reading is one pass through the rotor
+  // tables. Incrementing
+  // takes the ordinary stepping path, a single rotor step in most cases.
+  // Jumps (`+=`, `-`, `[]`) seek arithmetically, counting the notches passed
+  // by each rotor (as `Rotor::countKnocks`) instead of stepping, so any
+  // element costs `O(rotor_count)` to reach. Standard algorithms, including
+  // parallel ones, can therefore split and search ciphertext without
+  // materialising it.
+  //
+  // The view refers to the underlying range, which must outlive it. The
+  // tables are shared by the view and its iterators, so iterators remain
+  // valid after the view is gone (e.g. one taken from a temporary view).
+  // Dereferencing yields a value rather than a reference, so, as with the
+  // iterators of `std::views::iota`, the iterator category is input. Under
+  // C++20 the view is a `std::ranges::view` and its iterators model
+  // `std::random_access_iterator` (`iterator_concept`).
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count,
+           class SourceIt>
+  class EncodedView :
+      public detail::EncodedViewBase<
+        EncodedView<IndexT, base, rotor_count, SourceIt>> {
+  public:
+
+    using MachineType = EnigmaMachine<IndexT, base, rotor_count>;
+    using PositionArray = typename MachineType::PositionArray;
+    using Index = IndexT;
+
+    class iterator;
+
+    EncodedView() = default;
+
+    EncodedView(MachineType const & machine, SourceIt first, SourceIt last):
+        state(std::make_shared<State>(machine, first, last)) {}
+
+    template<class RangeT>
+    EncodedView(MachineType const & machine, RangeT & range):
+        EncodedView(machine, std::begin(range), std::end(range)) {}
+
+    [[nodiscard]] iterator begin() const {
+      return iterator{state, 0u};
+    }
+
+    [[nodiscard]] iterator end() const {
+      return iterator{state, size()};
+    }
+
+    [[nodiscard]] std::size_t size() const {
+      return state ? state->count : 0u;
+    }
+
+    [[nodiscard]] bool empty() const {
+      return size() == 0u;
+    }
+
+    [[nodiscard]] Index operator[](std::size_t i) const {
+      assert(i < size());
+      auto positions = state->start;
+      state->seek(positions, i + 1u);
+      return state->encode(positions, i);
+    }
+
+  private:
+
+    struct Tables {
+      std::array<Index, 2u * base> forward;
+      std::array<Index, 2u * base> reverse;
+      std::array<std::size_t, 2u * base + 1u> knocks;
+    };
+
+    // State struct --
+    // Everything an iterator reads, shared by the view and its iterators.
+    //
+    struct State {
+
+      State(MachineType const & machine, SourceIt first, SourceIt last):
+          source(first),
+          count(static_cast<std::size_t>(std::distance(first, last))),
+          start(machine.getPositions()) {
+        auto const & rotors = machine.getRotors();
+        for (auto r = 0u; r < rotor_count; ++r) {
+          auto & table = tables[r];
+          for (auto i = 0u; i < 2u * base; ++i) {
+            table.forward[i] = rotors[r].getForwardCipher()[i % base];
+            table.reverse[i] = rotors[r].getReverseCipher()[i % base];
+          }
+          fillKnocks(table.knocks, rotors[r].getNotches(), base);
+        }
+        reflector = machine.getReflector();
+      }
+
+      // seek --
+      // Advances `positions` by `steps`, carrying as `EnigmaMachine::advance`.
+      //
+      void seek(PositionArray & positions, std::size_t steps) const {
+        for (auto r = 0u; r < rotor_count && steps > 0u; ++r) {
+          auto position = positions[r];
+          positions[r] = (position + steps % base) % base;
+          steps = countKnocks(tables[r].knocks, base, position, steps);
+        }
+      }
+
+      // step --
+      // Advances `positions` by one step.
+      //
+      void step(PositionArray & positions) const {
+        for (auto r = 0u; r < rotor_count; ++r) {
+          if (++positions[r] == base) {
+            positions[r] = 0u;
+          }
+          if (!hasNotch(tables[r].knocks, positions[r])) {
+            break;
+          }
+        }
+      }
+
+      [[nodiscard]] Index encode(PositionArray const & positions,
+                                 std::size_t i) const {
+        auto val = static_cast<Index>(source[static_cast<std::ptrdiff_t>(i)]);
+        assert(val < base);
+        for (auto r = 0u; r < rotor_count; ++r) {
+          val = tables[r].forward[positions[r] + val];
+        }
+        val = reflector[val];
+        for (auto r = rotor_count; r-- > 0u;) {
+          val = tables[r].reverse[positions[r] + val];
+        }
+        return val;
+      }
+
+      SourceIt source;
+      std::size_t count;
+      PositionArray start;
+      std::array<Tables, rotor_count> tables = {};
+      std::array<Index, base> reflector = {};
+    };
+
+    std::shared_ptr<State const> state;
+  };
+
+  // EncodedView::iterator class -----------------------------------------------
+  // Holds the rotor positions of its element: the view's starting positions
+  // advanced `index + 1` times.
+  //
+  template<class IndexT, std::size_t base, std::size_t rotor_count,
+           class SourceIt>
+  class EncodedView<IndexT, base, rotor_count, SourceIt>::iterator {
+  public:
+
+    using iterator_category = std::input_iterator_tag;
+    using iterator_concept = std::random_access_iterator_tag;
+    using value_type = Index;
+    using difference_type = std::ptrdiff_t;
+    using reference = Index;
+    using pointer = void;
+
+    iterator() = default;
+
+    [[nodiscard]] Index operator*() const {
+      assert(index < state->count);
+      return state->encode(positions, index);
+    }
+
+    [[nodiscard]] Index operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    iterator & operator++() {
+      ++index;
+      state->step(positions);
+      return *this;
+    }
+
+    iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    iterator & operator--() {
+      return *this -= 1;
+    }
+
+    iterator operator--(int) {
+      auto copy = *this;
+      --*this;
+      return copy;
+    }
+
+    // operator+= --
+    // Seeks forward from the current positions, or back from the start.
+    //
+    iterator & operator+=(difference_type n) {
+      auto target = static_cast<std::size_t>(
+        static_cast<difference_type>(index) + n);
+      if (n >= 0) {
+        state->seek(positions, static_cast<std::size_t>(n));
+      } else {
+        positions = state->start;
+        state->seek(positions, target + 1u);
+      }
+      index = target;
+      return *this;
+    }
+
+    iterator & operator-=(difference_type n) {
+      return *this += -n;
+    }
+
+    [[nodiscard]] friend iterator operator+(iterator it, difference_type n) {
+      return it += n;
+    }
+
+    [[nodiscard]] friend iterator operator+(difference_type n, iterator it) {
+      return it += n;
+    }
+
+    [[nodiscard]] friend iterator operator-(iterator it, difference_type n) {
+      return it -= n;
+    }
+
+    [[nodiscard]] friend difference_type operator-(iterator const & lhs,
+                                                   iterator const & rhs) {
+      return static_cast<difference_type>(lhs.index) -
+             static_cast<difference_type>(rhs.index);
+    }
+
+    [[nodiscard]] friend bool operator==(iterator const & lhs,
+                                         iterator const & rhs) {
+      return lhs.index == rhs.index;
+    }
+
+    [[nodiscard]] friend bool operator!=(iterator const & lhs,
+                                         iterator const & rhs) {
+      return lhs.index != rhs.index;
+    }
+
+    [[nodiscard]] friend bool operator<(iterator const & lhs,
+                                        iterator const & rhs) {
+      return lhs.index < rhs.index;
+    }
+
+    [[nodiscard]] friend bool operator>(iterator const & lhs,
+                                        iterator const & rhs) {
+      return lhs.index > rhs.index;
+    }
+
+    [[nodiscard]] friend bool operator<=(iterator const & lhs,
+                                         iterator const & rhs) {
+      return lhs.index <= rhs.index;
+    }
+
+    [[nodiscard]] friend bool operator>=(iterator const & lhs,
+                                         iterator const & rhs) {
+      return lhs.index >= rhs.index;
+    }
+
+  private:
+
+    friend class EncodedView;
+
+    iterator(std::shared_ptr<State const> state, std::size_t index):
+        state(std::move(state)),
+        index(index) {
+      if (this->state) {
+        positions = this->state->start;
+        this->state->seek(positions, index + 1u);
+      }
+    }
+
+    std::shared_ptr<State const> state;
+    std::size_t index = 0u;
+    PositionArray positions = {};
+  };
+
+  // EncodedView class deduction guides ----------------------------------------
+
+  template<class T, class RangeT> EncodedView(T const &, RangeT &) ->
+    EncodedView<typename T::Index, T::getBase(), T::getRotorCount(),
+                decltype(std::begin(std::declval<RangeT &>()))>;
+
+  template<class T, class It> EncodedView(T const &, It, It) ->
+    EncodedView<typename T::Index, T::getBase(), T::getRotorCount(), It>;
+
+}
+
+#endif // ENIGMA_VIEW_HPP